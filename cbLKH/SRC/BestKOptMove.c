@@ -24,7 +24,7 @@
  * The function is called from the LinKernighan function. 
  */
 
-static GainType BestG2;
+static _Thread_local GainType BestG2;
 
 static GainType BestKOptMoveRec(int k, GainType G0);
 
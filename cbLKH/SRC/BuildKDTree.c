@@ -5,8 +5,8 @@ static void Partition(int start, int end, int k, int axis);
 static char FindMaxSpread(int start, int end);
 static void Swap(int i, int j);
 
-static Node **KDTree;
-static int cutoff;
+static _Thread_local Node **KDTree;
+static _Thread_local int cutoff;
 
 #define Coord(N, axis) (axis == 0 ? (N)->X : axis == 1 ? (N)->Y : (N)->Z)
 
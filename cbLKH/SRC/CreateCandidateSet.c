@@ -9,6 +9,9 @@
  * not available on file. In the latter case, the penalties is read from the 
  * file, and the lower bound is computed from a minimum 1-tree.      
  *
+ * If penalties and candidate sets are given in memory (ProblemCandidates, 
+ * see cbLKH.h), they are used as is, and no lower bound is computed.
+ *
  * The function GenerateCandidates is called to compute the Alpha-values and to 
  * associate to each node a set of incident candidate edges.  
  *
@@ -31,6 +34,29 @@ void CreateCandidateSet()
         }
         while ((Na = Na->Suc) != FirstNode);
     }
+    if (ProblemCandidates) {
+        int *Cand;
+        Na = FirstNode;
+        do
+            Na->Pi = ProblemPi[Na->Id - 1];
+        while ((Na = Na->Suc) != FirstNode);
+        Na = FirstNode;
+        do {
+            Cand = ProblemCandidates +
+                (size_t) (Na->Id - 1) * (2 * ProblemCandidatesPerNode + 1);
+            for (i = 0; i < Cand[0]; i++)
+                AddCandidate(Na, &NodeSet[Cand[2 * i + 1]],
+                             D(Na, &NodeSet[Cand[2 * i + 1]]),
+                             Cand[2 * i + 2]);
+        }
+        while ((Na = Na->Suc) != FirstNode);
+        ResetCandidateSet();
+        if (MaxCandidates > 0)
+            TrimCandidateSet(MaxCandidates);
+        AddTourCandidates();
+        CandidatesRead = 1;
+        goto End_CreateCandidateSet;
+    }
     if (Distance == Distance_1 ||
         (MaxTrials == 0 &&
          (FirstNode->InitialSuc || InitialTourAlgorithm == SIERPINSKI ||
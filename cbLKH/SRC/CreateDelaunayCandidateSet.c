@@ -8,7 +8,7 @@
  * The function is called from CreateCandidateSet.
  */
 
-static int Level = 0;
+static _Thread_local int Level = 0;
 
 void CreateDelaunayCandidateSet()
 {
@@ -15,13 +15,13 @@ static void ComputeBounds(int start, int end);
 typedef int (*ContainsFunction) (Node * T, int Q, Node * N);
 typedef int (*BoxOverlapsFunction) (Node * T, int Q, Node * N);
 
-static Node **KDTree;
-static Candidate *CandidateSet;
-static double *XMin, *XMax, *YMin, *YMax, *ZMin, *ZMax;
-static int Candidates, Radius;
-static ContainsFunction Contains;
-static BoxOverlapsFunction BoxOverlaps;
-static int Level = 0;
+static _Thread_local Node **KDTree;
+static _Thread_local Candidate *CandidateSet;
+static _Thread_local double *XMin, *XMax, *YMin, *YMax, *ZMin, *ZMax;
+static _Thread_local int Candidates, Radius;
+static _Thread_local ContainsFunction Contains;
+static _Thread_local BoxOverlapsFunction BoxOverlaps;
+static _Thread_local int Level = 0;
 
 /*
  * The CreateQuadrantCandidateSet function creates for each node 
@@ -456,10 +456,10 @@ static edge *make_edge(point * u, point * v)
     return e;
 }
 
-point *p_array;
-static edge *e_array;
-static edge **free_list_e;
-static int n_free_e;
+_Thread_local point *p_array;
+static _Thread_local edge *e_array;
+static _Thread_local edge **free_list_e;
+static _Thread_local int n_free_e;
 
 static void alloc_memory(int n)
 {
@@ -24,8 +24,8 @@
  * choosing foreign edges.
  */
 
-static Node *FirstFree;
-static int Tabu;
+static _Thread_local Node *FirstFree;
+static _Thread_local int Tabu;
 
 static Node *SelectNext(Node * N);
 
@@ -16,7 +16,7 @@
  */
 
 static void SwapCandidateSets();
-static GainType OrdinalTourCost;
+static _Thread_local GainType OrdinalTourCost;
 
 GainType FindTour()
 {
@@ -47,7 +47,8 @@ GainType FindTour()
     }
 
     for (Trial = 1; Trial <= MaxTrials; Trial++) {
-        if (GetTime() - EntryTime >= TimeLimit) {
+        if (GetTime() - EntryTime >= TimeLimit ||
+            (Cancelled() && Trial > 1)) {
             if (TraceLevel >= 1)
                 printff("*** Time limit exceeded ***\n");
             break;
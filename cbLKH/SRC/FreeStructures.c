@@ -20,6 +20,7 @@ void FreeStructures()
             N->C = 0;
         }
         Free(NodeSet);
+        FirstNode = 0;
     }
     Free(CostMatrix);
     Free(BestTour);
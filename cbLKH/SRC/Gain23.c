@@ -36,14 +36,21 @@
 
 GainType Gain23()
 {
-    static  Node *s1 = 0;
-    static short OldReversed = 0;
+    static _Thread_local Node *s1 = 0, *s1NodeSet = 0;
+    static _Thread_local int s1Dimension = 0;
+    static _Thread_local short OldReversed = 0;
     Node *s2, *s3, *s4, *s5, *s6 = 0, *s7, *s8 = 0, *s1Stop;
     Candidate *Ns2, *Ns4, *Ns6;
     GainType G0, G1, G2, G3, G4, G5, G6, Gain, Gain6;
     int X2, X4, X6, X8, Case6 = 0, Case8 = 0;
     int Breadth2, Breadth4, Breadth6;
 
+    /* s1 may be left over from a previously solved problem (see cbLKH.h) */
+    if (s1NodeSet != NodeSet || s1Dimension != Dimension) {
+        s1NodeSet = NodeSet;
+        s1Dimension = Dimension;
+        s1 = 0;
+    }
     if (!s1 || s1->Subproblem != FirstNode->Subproblem)
         s1 = FirstNode;
     s1Stop = s1;
@@ -11,17 +11,25 @@
  * the code.
  *
  * If the system call getrusage() is supported, the difference 
- * gives the user time used; otherwise, the accounted real time.
+ * gives the user time used (by the calling thread, if RUSAGE_THREAD
+ * is available); otherwise, the accounted real time.
  */
 
 #ifdef HAVE_GETRUSAGE
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
 #include <sys/time.h>
 #include <sys/resource.h>
 
 double GetTime()
 {
     struct rusage ru;
+#ifdef RUSAGE_THREAD
+    getrusage(RUSAGE_THREAD, &ru);
+#else
     getrusage(RUSAGE_SELF, &ru);
+#endif
     return ru.ru_utime.tv_sec + ru.ru_utime.tv_usec / 1000000.0;
 }
 
@@ -0,0 +1,9 @@
+/*
+ * This file defines the (thread-local) global variables declared in
+ * the header files.
+ */
+
+#define LKH_GLOBAL _Thread_local
+#include "LKH.h"
+#include "Genetic.h"
+#include "Sequence.h"
@@ -41,8 +41,8 @@ static void RemoveFromList(Node * N, Node ** First);
 static int compareX(const void *Na, const void *Nb);
 static int compareCost(const void *Na, const void *Nb);
 
-static int EdgesInFragments;
-static GainType Cost;
+static _Thread_local int EdgesInFragments;
+static _Thread_local GainType Cost;
 
 GainType GreedyTour()
 {
@@ -255,7 +255,7 @@ GainType GreedyTour()
 
 static Node *NearestNeighbor(Node * From)
 {
-    static int mark = 0;
+    static _Thread_local int mark = 0;
     Candidate *NN;
     Node *To, *N, *First = 0, *Last = 0, *Nearest = 0;
     int MaxLevel = Dimension, Min = INT_MAX, d;
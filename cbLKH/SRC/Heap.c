@@ -10,8 +10,8 @@
  * to the current tree). 
  */
 
-static int HeapCount;    /* Its current number of elements */
-static int HeapCapacity; /* Its capacity */
+static _Thread_local int HeapCount;    /* Its current number of elements */
+static _Thread_local int HeapCapacity; /* Its capacity */
 
 /*      
  * The MakeHeap function creates an empty heap. 
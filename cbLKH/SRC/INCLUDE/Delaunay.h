@@ -39,7 +39,7 @@ struct edge {
 
 typedef enum {right, left} side;
 
-extern point *p_array;
+extern _Thread_local point *p_array;
 
 void delaunay(int n);
 void free_memory();
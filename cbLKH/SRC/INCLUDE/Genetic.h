@@ -5,15 +5,17 @@
  * This header specifies the interface for the genetic algorithm part of LKH.
  */
 
+#include "LKH.h"
+
 typedef void (*CrossoverFunction) ();
 
-int MaxPopulationSize; /* The maximum size of the population */ 
-int PopulationSize;    /* The current size of the population */
+LKH_GLOBAL int MaxPopulationSize; /* The maximum size of the population */ 
+LKH_GLOBAL int PopulationSize;    /* The current size of the population */
 
-CrossoverFunction Crossover;
+LKH_GLOBAL CrossoverFunction Crossover;
 
-int **Population;      /* Array of individuals (solution tours) */
-GainType *Fitness;     /* The fitness (tour cost) of each individual */
+LKH_GLOBAL int **Population;      /* Array of individuals (solution tours) */
+LKH_GLOBAL GainType *Fitness;     /* The fitness (tour cost) of each individual */
 
 void AddToPopulation(GainType Cost);
 void ApplyCrossover(int i, int j);
@@ -12,6 +12,7 @@
 #include <float.h>
 #include <limits.h>
 #include <math.h>
+#include <setjmp.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
@@ -38,6 +39,9 @@
 #define Precede(a, b)\
     { Link((a)->Pred, (a)->Suc); Link(a, a); Link((b)->Pred, a); Link(a, b); }
 #define SLink(a, b) { (a)->Suc = (b); (b)->Pred = (a); }
+#define Cancelled()\
+    ((CancelFlag && __atomic_load_n(CancelFlag, __ATOMIC_RELAXED)) ||\
+     (StopFlag && __atomic_load_n(StopFlag, __ATOMIC_RELAXED)))
 
 enum Types { TSP, ATSP, SOP, HCP, CVRP, TOUR, HPP };
 enum CoordTypes { TWOD_COORDS, THREED_COORDS, NO_COORDS };
@@ -165,134 +169,142 @@ struct SwapRecord {
     Node *t1, *t2, *t3, *t4;    /* The 4 nodes involved in a 2-opt move */
 };
 
-int AscentCandidates;   /* Number of candidate edges to be associated
+/* All global variables are thread-local, so that each thread may run its
+   own instance of LKH (see cbLKH.h). They are declared extern here and
+   defined once in Globals.c */
+
+#ifndef LKH_GLOBAL
+#define LKH_GLOBAL extern _Thread_local
+#endif
+
+LKH_GLOBAL int AscentCandidates;   /* Number of candidate edges to be associated
                            with each node during the ascent */
-int BackboneTrials;     /* Number of backbone trials in each run */
-int Backtracking;       /* Specifies whether backtracking is used for 
+LKH_GLOBAL int BackboneTrials;     /* Number of backbone trials in each run */
+LKH_GLOBAL int Backtracking;       /* Specifies whether backtracking is used for 
                            the first move in a sequence of moves */
-GainType BestCost;      /* Cost of the tour in BestTour */
-int *BestTour;  /* Table containing best tour found */
-GainType BetterCost;    /* Cost of the tour stored in BetterTour */
-int *BetterTour;        /* Table containing the currently best tour 
+LKH_GLOBAL GainType BestCost;      /* Cost of the tour in BestTour */
+LKH_GLOBAL int *BestTour;  /* Table containing best tour found */
+LKH_GLOBAL GainType BetterCost;    /* Cost of the tour stored in BetterTour */
+LKH_GLOBAL int *BetterTour;        /* Table containing the currently best tour 
                            in a run */
-int CacheMask;  /* Mask for indexing the cache */
-int *CacheVal;  /* Table of cached distances */
-int *CacheSig;  /* Table of the signatures of cached 
+LKH_GLOBAL int CacheMask;  /* Mask for indexing the cache */
+LKH_GLOBAL int *CacheVal;  /* Table of cached distances */
+LKH_GLOBAL int *CacheSig;  /* Table of the signatures of cached 
                    distances */
-int CandidateFiles;     /* Number of CANDIDATE_FILEs */
-int *CostMatrix;        /* Cost matrix */
-int Dimension;  /* Number of nodes in the problem */
-int DimensionSaved;     /* Saved value of Dimension */
-double Excess;  /* Maximum alpha-value allowed for any 
+LKH_GLOBAL int CandidateFiles;     /* Number of CANDIDATE_FILEs */
+LKH_GLOBAL int *CostMatrix;        /* Cost matrix */
+LKH_GLOBAL int Dimension;  /* Number of nodes in the problem */
+LKH_GLOBAL int DimensionSaved;     /* Saved value of Dimension */
+LKH_GLOBAL double Excess;  /* Maximum alpha-value allowed for any 
                    candidate edge is set to Excess times the 
                    absolute value of the lower bound of a 
                    solution tour */
-int ExtraCandidates;    /* Number of extra neighbors to be added to 
+LKH_GLOBAL int ExtraCandidates;    /* Number of extra neighbors to be added to 
                            the candidate set of each node */
-Node *FirstActive, *LastActive; /* First and last node in the list 
+LKH_GLOBAL Node *FirstActive, *LastActive; /* First and last node in the list 
                                    of "active" nodes */
-Node *FirstNode;        /* First node in the list of nodes */
-Segment *FirstSegment;  /* A pointer to the first segment in the cyclic 
+LKH_GLOBAL Node *FirstNode;        /* First node in the list of nodes */
+LKH_GLOBAL Segment *FirstSegment;  /* A pointer to the first segment in the cyclic 
                            list of segments */
-SSegment *FirstSSegment;        /* A pointer to the first super segment in
+LKH_GLOBAL SSegment *FirstSSegment;        /* A pointer to the first super segment in
                                    the cyclic list of segments */
-int Gain23Used; /* Specifies whether Gain23 is used */
-int GainCriterionUsed;  /* Specifies whether L&K's gain criterion is 
+LKH_GLOBAL int Gain23Used; /* Specifies whether Gain23 is used */
+LKH_GLOBAL int GainCriterionUsed;  /* Specifies whether L&K's gain criterion is 
                            used */
-int GroupSize;  /* Desired initial size of each segment */
-int SGroupSize; /* Desired initial size of each super segment */
-int Groups;     /* Current number of segments */
-int SGroups;    /* Current number of super segments */
-unsigned Hash;  /* Hash value corresponding to the current tour */
-Node **Heap;    /* Heap used for computing minimum spanning 
+LKH_GLOBAL int GroupSize;  /* Desired initial size of each segment */
+LKH_GLOBAL int SGroupSize; /* Desired initial size of each super segment */
+LKH_GLOBAL int Groups;     /* Current number of segments */
+LKH_GLOBAL int SGroups;    /* Current number of super segments */
+LKH_GLOBAL unsigned Hash;  /* Hash value corresponding to the current tour */
+LKH_GLOBAL Node **Heap;    /* Heap used for computing minimum spanning 
                    trees */
-HashTable *HTable;      /* Hash table used for storing tours */
-int InitialPeriod;      /* Length of the first period in the ascent */
-int InitialStepSize;    /* Initial step size used in the ascent */
-double InitialTourFraction;     /* Fraction of the initial tour to be 
+LKH_GLOBAL HashTable *HTable;      /* Hash table used for storing tours */
+LKH_GLOBAL int InitialPeriod;      /* Length of the first period in the ascent */
+LKH_GLOBAL int InitialStepSize;    /* Initial step size used in the ascent */
+LKH_GLOBAL double InitialTourFraction;     /* Fraction of the initial tour to be 
                                    constructed by INITIAL_TOUR_FILE edges */
-char *LastLine; /* Last input line */
-double LowerBound;      /* Lower bound found by the ascent */
-int Kicks;      /* Specifies the number of K-swap-kicks */
-int KickType;   /* Specifies K for a K-swap-kick */
-int M;   /* The M-value is used when solving an ATSP-
+LKH_GLOBAL char *LastLine; /* Last input line */
+LKH_GLOBAL double LowerBound;      /* Lower bound found by the ascent */
+LKH_GLOBAL int Kicks;      /* Specifies the number of K-swap-kicks */
+LKH_GLOBAL int KickType;   /* Specifies K for a K-swap-kick */
+LKH_GLOBAL int M;   /* The M-value is used when solving an ATSP-
             instance by transforming it to a 
             STSP-instance */
-int MaxBreadth; /* The maximum number of candidate edges 
+LKH_GLOBAL int MaxBreadth; /* The maximum number of candidate edges 
                    considered at each level of the search for
                    a move */
-int MaxCandidates;      /* Maximum number of candidate edges to be 
+LKH_GLOBAL int MaxCandidates;      /* Maximum number of candidate edges to be 
                            associated with each node */
-int MaxMatrixDimension; /* Maximum dimension for an explicit cost matrix */
-int MaxSwaps;   /* Maximum number of swaps made during the 
+LKH_GLOBAL int MaxMatrixDimension; /* Maximum dimension for an explicit cost matrix */
+LKH_GLOBAL int MaxSwaps;   /* Maximum number of swaps made during the 
                    search for a move */
-int MaxTrials;  /* Maximum number of trials in each run */
-int MergeTourFiles;     /* Number of MERGE_TOUR_FILEs */
-int MoveType;   /* Specifies the sequantial move type to be used 
+LKH_GLOBAL int MaxTrials;  /* Maximum number of trials in each run */
+LKH_GLOBAL int MergeTourFiles;     /* Number of MERGE_TOUR_FILEs */
+LKH_GLOBAL int MoveType;   /* Specifies the sequantial move type to be used 
                    in local search. A value K >= 2 signifies 
                    that a k-opt moves are tried for k <= K */
-Node *NodeSet;  /* Array of all nodes */
-int Norm;       /* Measure of a 1-tree's discrepancy from a tour */
-int NonsequentialMoveType;      /* Specifies the nonsequential move type to
+LKH_GLOBAL Node *NodeSet;  /* Array of all nodes */
+LKH_GLOBAL int Norm;       /* Measure of a 1-tree's discrepancy from a tour */
+LKH_GLOBAL int NonsequentialMoveType;      /* Specifies the nonsequential move type to
                                    be used in local search. A value 
                                    L >= 4 signifies that nonsequential
                                    l-opt moves are tried for l <= L */
-GainType Optimum;       /* Known optimal tour length. 
+LKH_GLOBAL GainType Optimum;       /* Known optimal tour length. 
                            If StopAtOptimum is 1, a run will be 
                            terminated as soon as a tour length 
                            becomes equal this value */
-GainType MaxCost;       /* Upper bound on solution cost.
+LKH_GLOBAL GainType MaxCost;       /* Upper bound on solution cost.
                            If StopAtMaxCost is 1, a run will be 
                            terminated as soon as a tour length 
                            becomes less or equal this value */
-int PatchingA;  /* Specifies the maximum number of alternating
+LKH_GLOBAL int PatchingA;  /* Specifies the maximum number of alternating
                    cycles to be used for patching disjunct cycles */
-int PatchingC;  /* Specifies the maximum number of disjoint cycles to be 
+LKH_GLOBAL int PatchingC;  /* Specifies the maximum number of disjoint cycles to be 
                    patched (by one or more alternating cycles) */
-int Precision;  /* Internal precision in the representation of 
+LKH_GLOBAL int Precision;  /* Internal precision in the representation of 
                    transformed distances */
-int PredSucCostAvailable; /* PredCost and SucCost are available */
-unsigned *Rand; /* Table of random values */
-int RestrictedSearch;   /* Specifies whether the choice of the first 
+LKH_GLOBAL int PredSucCostAvailable; /* PredCost and SucCost are available */
+LKH_GLOBAL unsigned *Rand; /* Table of random values */
+LKH_GLOBAL int RestrictedSearch;   /* Specifies whether the choice of the first 
                            edge to be broken is restricted */
-short Reversed; /* Boolean used to indicate whether a tour has 
+LKH_GLOBAL short Reversed; /* Boolean used to indicate whether a tour has 
                    been reversed */
-int Run; /* Current run number */
-int Runs;       /* Total number of runs */
-unsigned Seed;  /* Initial seed for random number generation */
-int StopAtOptimum;      /* Specifies whether a run will be terminated if 
+LKH_GLOBAL int Run; /* Current run number */
+LKH_GLOBAL int Runs;       /* Total number of runs */
+LKH_GLOBAL unsigned Seed;  /* Initial seed for random number generation */
+LKH_GLOBAL int StopAtOptimum;      /* Specifies whether a run will be terminated if 
                            the tour length becomes equal to Optimum */
-int StopAtMaxCost;      /* Specifies whether a run will be terminated if 
+LKH_GLOBAL int StopAtMaxCost;      /* Specifies whether a run will be terminated if 
                            the tour length becomes less or equal to MaxCost */
-int Subgradient;        /* Specifies whether the Pi-values should be 
+LKH_GLOBAL int Subgradient;        /* Specifies whether the Pi-values should be 
                            determined by subgradient optimization */
-int SubproblemSize;     /* Number of nodes in a subproblem */
-int SubsequentMoveType; /* Specifies the move type to be used for all 
+LKH_GLOBAL int SubproblemSize;     /* Number of nodes in a subproblem */
+LKH_GLOBAL int SubsequentMoveType; /* Specifies the move type to be used for all 
                            moves following the first move in a sequence 
                            of moves. The value K >= 2 signifies that a 
                            K-opt move is to be used */
-int SubsequentPatching; /* Species whether patching is used for 
+LKH_GLOBAL int SubsequentPatching; /* Species whether patching is used for 
                            subsequent moves */
-SwapRecord *SwapStack;  /* Stack of SwapRecords */
-int Swaps;      /* Number of swaps made during a tentative move */
-double TimeLimit;       /* The time limit in seconds for each run */
-int TraceLevel; /* Specifies the level of detail of the output 
+LKH_GLOBAL SwapRecord *SwapStack;  /* Stack of SwapRecords */
+LKH_GLOBAL int Swaps;      /* Number of swaps made during a tentative move */
+LKH_GLOBAL double TimeLimit;       /* The time limit in seconds for each run */
+LKH_GLOBAL int TraceLevel; /* Specifies the level of detail of the output 
                    given during the solution process. 
                    The value 0 signifies a minimum amount of 
                    output. The higher the value is the more 
                    information is given */
-int Trial;      /* Ordinal number of the current trial */
+LKH_GLOBAL int Trial;      /* Ordinal number of the current trial */
 
 /* The following variables are read by the functions ReadParameters and 
    ReadProblem: */
 
-char *ParameterFileName, *ProblemFileName, *PiFileName,
+LKH_GLOBAL char *ParameterFileName, *ProblemFileName, *PiFileName,
     *TourFileName, *OutputTourFileName, *InputTourFileName,
     **CandidateFileName, *InitialTourFileName,
     *SubproblemTourFileName, **MergeTourFileName;
-char *Name, *Type, *EdgeWeightType, *EdgeWeightFormat,
+LKH_GLOBAL char *Name, *Type, *EdgeWeightType, *EdgeWeightFormat,
     *EdgeDataFormat, *NodeCoordType, *DisplayDataType;
-int CandidateSetSymmetric, CandidateSetType,
+LKH_GLOBAL int CandidateSetSymmetric, CandidateSetType,
     CoordType, DelaunayPartitioning, DelaunayPure,
     ExtraCandidateSetSymmetric, ExtraCandidateSetType,
     InitialTourAlgorithm,
@@ -304,10 +316,32 @@ int CandidateSetSymmetric, CandidateSetType,
     RohePartitioning, SierpinskiPartitioning,
     SubproblemBorders, SubproblemsCompressed, WeightType, WeightFormat;
 
-FILE *ParameterFile, *ProblemFile, *PiFile, *InputTourFile,
+LKH_GLOBAL FILE *ParameterFile, *ProblemFile, *PiFile, *InputTourFile,
     *TourFile, *InitialTourFile, *SubproblemTourFile, **MergeTourFile;
-CostFunction Distance, D, C, c;
-MoveFunction BestMove, BacktrackMove, BestSubsequentMove;
+LKH_GLOBAL CostFunction Distance, D, C, c;
+LKH_GLOBAL MoveFunction BestMove, BacktrackMove, BestSubsequentMove;
+
+/* The following variables are used when LKH is called as a library 
+   (see cbLKH.h): */
+
+LKH_GLOBAL int *ProblemMatrix;  /* ATSP cost matrix given in memory, in 
+                                   row-major order. If nonzero, it is used
+                                   instead of PROBLEM_FILE */
+LKH_GLOBAL int ProblemMatrixDimension; /* Number of rows in ProblemMatrix */
+LKH_GLOBAL int *ProblemInitialTour; /* Initial tour given in memory, as a
+                                       permutation of 0..n-1. If nonzero, 
+                                       it is used instead of 
+                                       INITIAL_TOUR_FILE */
+LKH_GLOBAL int *ProblemPi;      /* Penalties given in memory, one per node */
+LKH_GLOBAL int *ProblemCandidates; /* Candidate sets given in memory. If 
+                                      nonzero, they are used together with 
+                                      ProblemPi instead of an ascent */
+LKH_GLOBAL int ProblemCandidatesPerNode; /* Stride of ProblemCandidates */
+LKH_GLOBAL jmp_buf *ErrorJump;  /* If nonzero, eprintf returns control
+                                   here instead of exiting */
+LKH_GLOBAL const int *CancelFlag; /* If nonzero, the search stops as soon
+                                     as *CancelFlag is set (read atomically) */
+LKH_GLOBAL const int *StopFlag; /* Likewise, for a second flag */
 
 /* Function prototypes: */
 
@@ -430,6 +464,7 @@ void RecordBetterTour(void);
 Node *RemoveFirstActive(void);
 void ResetCandidateSet(void);
 void RestoreTour(void);
+GainType RunLKH(void);
 int SegmentSize(Node *ta, Node *tb);
 GainType SFCTour(int CurveType);
 void SolveCompressedSubproblem(int CurrentSubproblem, int Subproblems, 
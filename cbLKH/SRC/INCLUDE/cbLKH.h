@@ -0,0 +1,72 @@
+#ifndef _CBLKH_H
+#define _CBLKH_H
+
+/*
+ * This header specifies the interface for calling LKH as a library.
+ *
+ * All global variables of LKH are thread-local. Hence, LKH_SolveMatrix 
+ * may be called concurrently from several threads, each thread running its 
+ * own instance of LKH.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * The LKH_SolveMatrix function solves an ATSP given by an in-memory cost 
+ * matrix.
+ *
+ * Parameters is the contents of a parameter file (see ReadParameters.c), 
+ * except that PROBLEM_FILE must not be given. Matrix is the n x n cost 
+ * matrix in row-major order, where Matrix[i * n + j] is the cost of going 
+ * from node i to node j (0 <= i, j < n, n >= 3).
+ *
+ * If InitialTour is nonzero, it is a permutation of 0..n-1 used as the
+ * initial tour of the first trial (as if given by INITIAL_TOUR_FILE).
+ *
+ * If Pi is nonzero, Pi and Candidates give the penalties and candidate 
+ * sets of the 2n nodes of the transformed problem, in the format written 
+ * by LKH_CreateCandidates, and no ascent is made.
+ *
+ * On return Tour[0..n-1] contains the best tour found (as a permutation of 
+ * 0..n-1), and Cost contains its cost.
+ *
+ * If Cancel is nonzero, the search is stopped (as if the time limit had 
+ * been exceeded) as soon as another thread sets *Cancel to a nonzero value.
+ * *Cancel is read with __atomic_load_n, so it must be set atomically (e.g.
+ * as a C++ std::atomic<int>).
+ * Stop is a second such flag, so that a caller may run several searches 
+ * on the same problem and stop the rest once one has succeeded, while 
+ * still honoring its own Cancel flag. *Stop is read the same way.
+ *
+ * The function returns 1 if a tour was found, and 0 otherwise (e.g., on an 
+ * error in the parameters).
+ */
+
+int LKH_SolveMatrix(const char *Parameters, int n, const int *Matrix,
+                    const int *InitialTour, const int *Pi,
+                    const int *Candidates, int CandidatesPerNode,
+                    int *Tour, long long *Cost, const int *Cancel,
+                    const int *Stop);
+
+/*
+ * The LKH_CreateCandidates function computes the penalties and the alpha 
+ * candidate sets of the ATSP given by Matrix, transformed into a symmetric 
+ * problem on 2n nodes, without searching for a tour.
+ *
+ * On return Pi[0..2n-1] contains the penalty of each node, and for node i
+ * (1 <= i <= 2n) the CandidatesPerNode*2+1 integers starting at 
+ * Candidates[(i-1)*(2*CandidatesPerNode+1)] contain the number of 
+ * candidates followed by their (node, alpha) pairs, in order of alpha.
+ *
+ * The function returns 1 on success, and 0 otherwise.
+ */
+
+int LKH_CreateCandidates(const char *Parameters, int n, const int *Matrix,
+                         int CandidatesPerNode, int *Pi, int *Candidates);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
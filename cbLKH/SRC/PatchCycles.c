@@ -21,7 +21,7 @@ static GainType PatchCyclesRec(int k, int m, int M, GainType G0);
 static int ShortestCycle(int M, int k);
 static int Cycle(Node * N, int k);
 
-static int CurrentCycle, Patchwork = 0, RecLevel = 0;
+static _Thread_local int CurrentCycle, Patchwork = 0, RecLevel = 0;
 #define MaxPatchwork Dimension
 
 /*
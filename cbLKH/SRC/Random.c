@@ -38,7 +38,7 @@ void SRandom(unsigned Seed)
 #include <limits.h>
 #define PRANDMAX INT_MAX
 
-static int a = 0, b = 24, arr[55], initialized = 0;
+static _Thread_local int a = 0, b = 24, arr[55], initialized = 0;
 
 unsigned Random()
 {
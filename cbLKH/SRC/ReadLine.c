@@ -6,8 +6,8 @@
  * return, a newline, both, or EOF.
  */
 
-static char *Buffer;
-static int MaxBuffer;
+static _Thread_local char *Buffer;
+static _Thread_local int MaxBuffer;
 
 static int EndOfLine(FILE * InputFile, int c)
 {
@@ -358,7 +358,8 @@ void ReadParameters()
     unsigned int i;
 
     ProblemFileName = PiFileName = InputTourFileName =
-        OutputTourFileName = TourFileName = 0;
+        OutputTourFileName = TourFileName = InitialTourFileName =
+        SubproblemTourFileName = 0;
     CandidateFiles = MergeTourFiles = 0;
     AscentCandidates = 50;
     BackboneTrials = 0;
@@ -416,7 +417,8 @@ void ReadParameters()
     TraceLevel = 1;
 	MaxCost = MINUS_INFINITY;
 
-    if (ParameterFileName) {
+    if (ParameterFile);         /* Already opened by the caller */
+    else if (ParameterFileName) {
         if (!(ParameterFile = fopen(ParameterFileName, "r")))
             eprintf("Cannot open PARAMETER_FILE: \"%s\"",
                     ParameterFileName);
@@ -833,13 +835,14 @@ void ReadParameters()
         if ((Token = strtok(0, Delimiters)) && Token[0] != '#')
             eprintf("Junk at end of line: %s", Token);
     }
-    if (!ProblemFileName)
+    if (!ProblemFileName && !ProblemMatrix)
         eprintf("Problem file name is missing");
     if (SubproblemSize == 0 && SubproblemTourFileName != 0)
         eprintf("SUBPROBLEM_SIZE specification is missing");
     if (SubproblemSize > 0 && SubproblemTourFileName == 0)
         eprintf("SUBPROBLEM_TOUR_FILE specification is missing");
     fclose(ParameterFile);
+    ParameterFile = 0;
     free(LastLine);
     LastLine = 0;
 }
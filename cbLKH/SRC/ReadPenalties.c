@@ -20,7 +20,7 @@ int ReadPenalties()
 {
     int i, Id;
     Node *Na, *Nb = 0;
-    static int PenaltiesRead = 0;
+    static _Thread_local int PenaltiesRead = 0;
 
     if (PiFileName == 0)
         return 0;
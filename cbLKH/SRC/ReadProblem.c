@@ -5,6 +5,10 @@
  * The ReadProblem function reads the problem data in TSPLIB format from the 
  * file specified in the parameter file (PROBLEM_FILE).
  *
+ * If ProblemMatrix is nonzero, no file is read. Instead the problem is 
+ * taken to be an ATSP of dimension ProblemMatrixDimension whose FULL_MATRIX 
+ * of edge weights is given by ProblemMatrix (see cbLKH.h).
+ *
  * The following description of the file format is extracted from the TSPLIB 
  * documentation.  
  *
@@ -210,6 +214,8 @@ static void Read_FIXED_EDGES_SECTION(void);
 static void Read_NAME(void);
 static void Read_NODE_COORD_SECTION(void);
 static void Read_NODE_COORD_TYPE(void);
+static void Read_PROBLEM_MATRIX(void);
+static void Read_PROBLEM_INITIAL_TOUR(void);
 static void Read_TOUR_SECTION(FILE ** File);
 static void Read_TYPE(void);
 static int TwoDWeightType(void);
@@ -220,9 +226,11 @@ void ReadProblem()
     int i, K;
     char *Line, *Keyword;
 
-    if (!(ProblemFile = fopen(ProblemFileName, "r")))
+    if (ProblemMatrix)
+        ProblemFile = 0;
+    else if (!(ProblemFile = fopen(ProblemFileName, "r")))
         eprintf("Cannot open PROBLEM_FILE: \"%s\"", ProblemFileName);
-    if (TraceLevel >= 1)
+    if (TraceLevel >= 1 && ProblemFile)
         printff("Reading PROBLEM_FILE: \"%s\" ... ", ProblemFileName);
     FreeStructures();
     FirstNode = 0;
@@ -234,7 +242,10 @@ void ReadProblem()
     Distance = 0;
     C = 0;
     c = 0;
-    while ((Line = ReadLine(ProblemFile))) {
+    M = 0;
+    if (ProblemMatrix)
+        Read_PROBLEM_MATRIX();
+    while (ProblemFile && (Line = ReadLine(ProblemFile))) {
         if (!(Keyword = strtok(Line, Delimiters)))
             continue;
         for (i = 0; i < (int) strlen(Keyword); i++)
@@ -380,12 +391,15 @@ void ReadProblem()
     if (TraceLevel >= 1) {
         printff("done\n");
         PrintParameters();
-    } else
+    } else if (ProblemFile)
         printff("PROBLEM_FILE = %s\n",
                 ProblemFileName ? ProblemFileName : "");
-    fclose(ProblemFile);
+    if (ProblemFile)
+        fclose(ProblemFile);
     if (InitialTourFileName)
         ReadTour(InitialTourFileName, &InitialTourFile);
+    else if (ProblemInitialTour)
+        Read_PROBLEM_INITIAL_TOUR();
     if (InputTourFileName)
         ReadTour(InputTourFileName, &InputTourFile);
     if (SubproblemTourFileName && SubproblemSize > 0)
@@ -835,7 +849,9 @@ static void Read_EDGE_WEIGHT_SECTION()
             for (i = 1; i <= n; i++) {
                 Ni = &NodeSet[i];
                 for (j = 1; j <= n; j++) {
-                    if (!fscanint(ProblemFile, &W))
+                    if (ProblemMatrix)
+                        W = ProblemMatrix[(size_t) (i - 1) * n + j - 1];
+                    else if (!fscanint(ProblemFile, &W))
                         eprintf("Missing weight in EDGE_WEIGHT_SECTION");
                     Ni->C[j] = W;
                     if (i != j && W > M)
@@ -1264,6 +1280,63 @@ static void Read_TOUR_SECTION(FILE ** File)
         printff("done\n");
 }
 
+/*
+   The Read_PROBLEM_MATRIX function sets up the specification part of an 
+   ATSP given by the in-memory matrix ProblemMatrix, and then reads its 
+   edge weights as an EDGE_WEIGHT_SECTION.
+*/
+
+static void Read_PROBLEM_MATRIX()
+{
+    free(Name);
+    Name = Copy("ProblemMatrix");
+    Type = Copy("ATSP");
+    ProblemType = ATSP;
+    EdgeWeightType = Copy("EXPLICIT");
+    WeightType = EXPLICIT;
+    EdgeWeightFormat = Copy("FULL_MATRIX");
+    WeightFormat = FULL_MATRIX;
+    Dimension = DimensionSaved = ProblemMatrixDimension;
+    Read_EDGE_WEIGHT_SECTION();
+}
+
+/*
+   The Read_PROBLEM_INITIAL_TOUR function reads the initial tour of the
+   in-memory ATSP from ProblemInitialTour, as Read_TOUR_SECTION would read
+   the TOUR_SECTION of an INITIAL_TOUR_FILE.
+*/
+
+static void Read_PROBLEM_INITIAL_TOUR()
+{
+    Node *First = 0, *Last = 0, *N, *Na;
+    int i, k;
+
+    N = FirstNode;
+    do
+        N->V = 0;
+    while ((N = N->Suc) != FirstNode);
+    Dimension /= 2;
+    for (k = 0; k <= Dimension; k++) {
+        i = k < Dimension ? ProblemInitialTour[k] + 1 : First->Id;
+        if (i <= 0 || i > Dimension)
+            eprintf("(INITIAL_TOUR) Node number out of range: %d", i);
+        N = &NodeSet[i];
+        if (N->V == 1 && k != Dimension)
+            eprintf("(INITIAL_TOUR) Node number occurs twice: %d", N->Id);
+        N->V = 1;
+        if (k == 0)
+            First = Last = N;
+        else {
+            Na = N + Dimension;
+            Na->V = 1;
+            Last->InitialSuc = Na;
+            Na->InitialSuc = N;
+            Last = N;
+        }
+    }
+    Dimension *= 2;
+}
+
 static void Read_TYPE()
 {
     unsigned int i;
@@ -17,7 +17,7 @@
  *     BETWEEN(t[p[i-1]], t[p[i]], t[p[i+1]]) for i = 2, ..., 2k-1
  */
 
-static Node *tp1;
+static _Thread_local Node *tp1;
 
 static int compare(const void *pa, const void *pb)
 {
@@ -18,9 +18,9 @@
 static void KarpPartition(int start, int end);
 static void CalculateSubproblems(int start, int end);
 
-static Node **KDTree;
-static GainType GlobalBestCost, OldGlobalBestCost;
-static int CurrentSubproblem, Subproblems;
+static _Thread_local Node **KDTree;
+static _Thread_local GainType GlobalBestCost, OldGlobalBestCost;
+static _Thread_local int CurrentSubproblem, Subproblems;
 
 void SolveKarpSubproblems()
 {
@@ -0,0 +1,143 @@
+#include "LKH.h"
+#include "cbLKH.h"
+#include <pthread.h>
+
+/*
+ * The LKH_SolveMatrix function solves an ATSP given by an in-memory cost
+ * matrix (see cbLKH.h).
+ *
+ * The parameters are read from the string Parameters, and the problem is
+ * read from Matrix and InitialTour (see ReadProblem). The parsing is
+ * serialized by a mutex, since ReadParameters uses the non-reentrant strtok
+ * function. The solution itself is found by RunLKH without any locking.
+ *
+ * Any error reported by eprintf returns control to this function, which
+ * then frees all allocated structures and returns 0.
+ */
+
+static pthread_mutex_t ReadMutex = PTHREAD_MUTEX_INITIALIZER;
+
+static void ReadMatrix(const char *Parameters, int n, const int *Matrix,
+                       volatile int *Locked);
+static void Reset(void);
+
+int LKH_SolveMatrix(const char *Parameters, int n, const int *Matrix,
+                    const int *InitialTour, const int *Pi,
+                    const int *Candidates, int CandidatesPerNode,
+                    int *Tour, long long *Cost, const int *Cancel,
+                    const int *Stop)
+{
+    jmp_buf Jump;
+    volatile int Locked = 0;
+    GainType BestTourCost;
+    int i;
+
+    if (setjmp(Jump)) {
+        if (Locked)
+            pthread_mutex_unlock(&ReadMutex);
+        Reset();
+        return 0;
+    }
+    ErrorJump = &Jump;
+
+    ProblemInitialTour = (int *) InitialTour;
+    ReadMatrix(Parameters, n, Matrix, &Locked);
+
+    CancelFlag = Cancel;
+    StopFlag = Stop;
+    ProblemPi = (int *) Pi;
+    ProblemCandidates = Pi ? (int *) Candidates : 0;
+    ProblemCandidatesPerNode = CandidatesPerNode;
+    BestTourCost = RunLKH();
+    if (BestTourCost != PLUS_INFINITY) {
+        for (i = 0; i < n; i++)
+            Tour[i] = BestTour[i + 1] - 1;
+        *Cost = BestTourCost;
+    }
+    Reset();
+    return BestTourCost != PLUS_INFINITY;
+}
+
+/*
+ * The LKH_CreateCandidates function computes the penalties and the alpha
+ * candidate sets of an ATSP given by an in-memory cost matrix (see cbLKH.h),
+ * without searching for a tour.
+ */
+
+int LKH_CreateCandidates(const char *Parameters, int n, const int *Matrix,
+                         int CandidatesPerNode, int *Pi, int *Candidates)
+{
+    jmp_buf Jump;
+    volatile int Locked = 0;
+    Candidate *NN;
+    int *Cand, i, Count;
+
+    if (setjmp(Jump)) {
+        if (Locked)
+            pthread_mutex_unlock(&ReadMutex);
+        Reset();
+        return 0;
+    }
+    ErrorJump = &Jump;
+
+    ReadMatrix(Parameters, n, Matrix, &Locked);
+
+    AllocateStructures();
+    CreateCandidateSet();
+    for (i = 1; i <= 2 * n; i++) {
+        Pi[i - 1] = NodeSet[i].Pi;
+        Cand = Candidates + (size_t) (i - 1) * (2 * CandidatesPerNode + 1);
+        Count = 0;
+        for (NN = NodeSet[i].CandidateSet;
+             NN && NN->To && Count < CandidatesPerNode; NN++, Count++) {
+            Cand[2 * Count + 1] = NN->To->Id;
+            Cand[2 * Count + 2] = NN->Alpha;
+        }
+        Cand[0] = Count;
+    }
+    Reset();
+    return 1;
+}
+
+/*
+ * The ReadMatrix function reads the parameters and the problem under the
+ * ReadMutex.
+ */
+
+static void ReadMatrix(const char *Parameters, int n, const int *Matrix,
+                       volatile int *Locked)
+{
+    pthread_mutex_lock(&ReadMutex);
+    *Locked = 1;
+    ProblemMatrix = (int *) Matrix;
+    ProblemMatrixDimension = n;
+    if (!(ParameterFile =
+          fmemopen((void *) Parameters, strlen(Parameters), "r")))
+        eprintf("Cannot read parameters");
+    ReadParameters();
+    MaxMatrixDimension = 10000;
+    ReadProblem();
+    pthread_mutex_unlock(&ReadMutex);
+    *Locked = 0;
+}
+
+/*
+ * The Reset function clears the in-memory problem and frees all allocated
+ * structures.
+ */
+
+static void Reset()
+{
+    if (ParameterFile) {
+        fclose(ParameterFile);
+        ParameterFile = 0;
+    }
+    ErrorJump = 0;
+    CancelFlag = 0;
+    StopFlag = 0;
+    ProblemMatrix = 0;
+    ProblemInitialTour = 0;
+    ProblemPi = 0;
+    ProblemCandidates = 0;
+    FreeStructures();
+}
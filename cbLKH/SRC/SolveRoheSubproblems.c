@@ -24,8 +24,8 @@ static void WindowSize(double XMin, double XMax, double YMin, double YMax,
 static void MakeSubproblem(double XMin, double XMax, double YMin,
                            double YMax, double ZMin, double ZMax,
                            int Subproblem, int start, int end);
-static int Size;
-static Node **KDTree;
+static _Thread_local int Size;
+static _Thread_local Node **KDTree;
 
 void SolveRoheSubproblems()
 {
@@ -1,8 +1,8 @@
 #include "LKH.h"
 
-static int TrialsMin, TrialsMax, TrialSum, Successes;
-static GainType CostMin, CostMax, CostSum;
-static double TimeMin, TimeMax, TimeSum;
+static _Thread_local int TrialsMin, TrialsMax, TrialSum, Successes;
+static _Thread_local GainType CostMin, CostMax, CostSum;
+static _Thread_local double TimeMin, TimeMax, TimeSum;
 
 void InitializeStatistics()
 {
@@ -3,6 +3,9 @@
 
 /* 
  * The eprintf function prints an error message and exits.
+ * 
+ * If ErrorJump is set (LKH is called as a library), control is returned 
+ * to the caller by a longjmp instead.
  */
 
 void eprintf(const char *fmt, ...)
@@ -16,5 +19,7 @@ void eprintf(const char *fmt, ...)
     vfprintf(stderr, fmt, args);
     va_end(args);
     fprintf(stderr, "\n");
+    if (ErrorJump)
+        longjmp(*ErrorJump, 1);
     exit(EXIT_FAILURE);
 }
@@ -112,6 +112,8 @@ Solver::Solver() :
     trail_shrink_callback   = &trail_shrink_callback_nop;
     check_conflict_callback = &check_conflict_callback_nop;
     within_budget_callback  = &within_budget_callback_nop;
+    export_clause_callback  = &export_clause_callback_nop;
+    import_clause_callback  = &import_clause_callback_nop;
 }
 
 
@@ -230,6 +232,26 @@ void Solver::attachClause(CRef cr){
 }
 
 
+/*****************************************************************************
+ * cb_minisat
+ *   Theory conflicts are falsified clauses. Watch the two literals assigned
+ *   last so the watches stay valid once the solver backtracks.
+ ****************************************************************************/
+CRef Solver::attachConflict(vec<Lit>& ps){
+    for (int w = 0; w < 2 && w < ps.size(); w++){
+        int max_i = w;
+        for (int i = w+1; i < ps.size(); i++)
+            if (value(ps[i]) != l_False || (value(ps[max_i]) == l_False && level(var(ps[i])) > level(var(ps[max_i]))))
+                max_i = i;
+        Lit tmp = ps[w]; ps[w] = ps[max_i]; ps[max_i] = tmp;
+    }
+    CRef cr = ca.alloc(ps, false);
+    clauses.push(cr);
+    attachClause(cr);
+    return cr;
+}
+
+
 void Solver::detachClause(CRef cr, bool strict){
     const Clause& c = ca[cr];
     assert(c.size() > 1);
@@ -613,6 +635,7 @@ CRef Solver::propagate()
 {
     CRef    confl     = CRef_Undef;
     int     num_props = 0;
+    bool    theory_confl = false;
     vec<Lit>  ps;
 
     while (qhead < trail.size()){
@@ -655,15 +678,10 @@ CRef Solver::propagate()
                 confl = cr;
             } else {
                 uncheckedEnqueue(first, cr);
-                if (check_conflict_callback(callback_obj_pt, assigns, trail, ps)) {
-                    CRef cr2 = ca.alloc(ps, false);
-                    clauses.push(cr2);
-                    attachClause(cr2);
-                    confl = cr2;
-//printf("new confl = %d\n", cr2);
-		        }
+                // attached below, attaching may grow ws while it is in use
+                theory_confl = check_conflict_callback(callback_obj_pt, assigns, trail, ps);
             }
-            if (confl != CRef_Undef) {
+            if (confl != CRef_Undef || theory_confl) {
               qhead = trail.size();
               // Copy the remaining watches:
               while (i < end)
@@ -673,17 +691,15 @@ CRef Solver::propagate()
         NextClause:;
         }
         ws.shrink(i - j);
+        if (theory_confl)
+            confl = attachConflict(ps);
     }
     propagations += num_props;
     simpDB_props -= num_props;
 
     if (confl == CRef_Undef) {
-        if (check_conflict_callback(callback_obj_pt, assigns, trail, ps)) {
-            CRef cr2 = ca.alloc(ps, false);
-            clauses.push(cr2);
-            attachClause(cr2);
-            confl = cr2;
-        }
+        if (check_conflict_callback(callback_obj_pt, assigns, trail, ps))
+            confl = attachConflict(ps);
     }
     return confl;
 }
@@ -840,9 +856,25 @@ lbool Solver::search(int nof_conflicts)
             conflicts++; conflictC++;
             if (decisionLevel() == 0) return l_False;
 
+            /*****************************************************************************
+             * cb_minisat
+             *   A theory conflict need not contain a literal of the current level
+             *   (shrunk explanations, checks every few pushes). analyze() requires
+             *   one, so first backjump to the highest level in the clause.
+             ****************************************************************************/
+            int confl_level = 0;
+            const Clause& c = ca[confl];
+            for (int i = 0; i < c.size(); i++)
+                if (level(var(c[i])) > confl_level)
+                    confl_level = level(var(c[i]));
+            if (confl_level == 0) return l_False;
+            if (confl_level < decisionLevel())
+                cancelUntil(confl_level);
+
             learnt_clause.clear();
             analyze(confl, learnt_clause, backtrack_level);
             cancelUntil(backtrack_level);
+            export_clause_callback(callback_obj_pt, learnt_clause);
 
             // hack
             if (learnt_clause.size() > 0) {
@@ -880,6 +912,23 @@ lbool Solver::search(int nof_conflicts)
                 cancelUntil(0);
                 return l_Undef; }
 
+            /*****************************************************************************
+             * cb_minisat
+             *   Clauses learnt by other solvers on the same problem are added at the
+             *   root, then propagated before the next decision.
+             ****************************************************************************/
+            if (decisionLevel() == 0){
+                bool imported = false;
+                vec<Lit> ps;
+                while (import_clause_callback(callback_obj_pt, ps)){
+                    if (!addClause_(ps))
+                        return l_False;
+                    imported = true;
+                }
+                if (imported)
+                    continue;
+            }
+
             // Simplify the set of problem clauses:
             if (decisionLevel() == 0 && !simplify())
                 return l_False;
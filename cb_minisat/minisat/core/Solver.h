@@ -167,6 +167,10 @@ public:
     bool (*check_conflict_callback)         (void* object_pointer, const VMap<lbool> &assigns, const vec<Lit>& trail, vec<Lit>& ps);
     static bool within_budget_callback_nop (void* object_pointer) {return true;}
     bool (*within_budget_callback)          (void* object_pointer);
+    static void export_clause_callback_nop  (void* object_pointer, const vec<Lit>& ps) {}
+    void (*export_clause_callback)          (void* object_pointer, const vec<Lit>& ps);
+    static bool import_clause_callback_nop  (void* object_pointer, vec<Lit>& ps) {return false;}
+    bool (*import_clause_callback)          (void* object_pointer, vec<Lit>& ps);
     int callback_error;
     enum {LIT_REDUNANT_ERROR, CALLBACK_ERROR};
 
@@ -286,6 +290,7 @@ protected:
     // Operations on clauses:
     //
     void     attachClause     (CRef cr);               // Attach a clause to watcher lists.
+    CRef     attachConflict   (vec<Lit>& ps);          // Allocate and attach a theory conflict clause.
     void     detachClause     (CRef cr, bool strict = false); // Detach a clause to watcher lists.
     void     removeClause     (CRef cr);               // Detach and free a clause.
     bool     isRemoved        (CRef cr) const;         // Test if a clause has been removed.
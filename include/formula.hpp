@@ -49,6 +49,7 @@ enum { F_AND, F_OR, F_XOR, F_NXOR };
  ********************************************************************************/
 
 class Formula;
+class CNF;
 
 Lit translate  (const int &lit);
 int translate  (const Lit &lit);
@@ -103,6 +104,42 @@ class Formula {
 };
 
 
+/************************************************************//**
+ * @brief	            Flat in-memory snapshot of a CNF formula
+ * @version						v0.01b
+ *
+ * Filled once by parse_DIMACS() (it provides the nVars(), newVar()
+ * and addClause_() interface of a Solver), after which load() bulk
+ * copies the variables and clauses into any number of fresh Solvers.
+ *
+ * map() instead views clauses stored elsewhere (a compiled instance),
+ * which must outlive the snapshot and all of its copies.
+ ****************************************************************/
+class CNF {
+    private:
+        int num_vars;
+        vec<Lit> lits;              // literals of all clauses, back to back
+        vec<int> clause_ends;       // end of each clause in lits
+        const Lit *mapped_lits;     // NULL unless mapped
+        const int *mapped_ends;
+        int mapped_clauses;
+
+    public:
+        CNF () : num_vars(0), mapped_lits(NULL), mapped_ends(NULL), mapped_clauses(0) {};
+
+        int nVars () const { return num_vars; };
+        int nClauses () const { return mapped_ends ? mapped_clauses : clause_ends.size(); };
+        int nLits () const { return nClauses() > 0 ? clauseEnds()[nClauses()-1] : 0; };
+        const Lit* clauseLits () const { return mapped_ends ? mapped_lits : (lits.size() ? &lits[0] : NULL); };
+        const int* clauseEnds () const { return mapped_ends ? mapped_ends : (clause_ends.size() ? &clause_ends[0] : NULL); };
+        Var newVar () { return num_vars++; };
+        bool addClause_ (vec<Lit> &clause);
+        void map (int num_vars, int num_clauses, const Lit *lits, const int *clause_ends);
+        bool load (Solver &solver) const;
+        void copyTo (CNF &copy) const;
+};
+
+
 
 } // end namespace
 #endif
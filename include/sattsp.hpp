@@ -33,6 +33,8 @@
 #include <vector>
 #include <algorithm>
 #include <sys/time.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include <boost/format.hpp>
 #include <boost/algorithm/string.hpp>
 
@@ -61,25 +63,62 @@ enum SEARCH_METHOD {LINEAR, BINARY, ADAPTIVE_BINARY};
  * Prototypes
  ********************************************************************************/
 
+/************************************************************//**
+ * @brief	Clauses shared between the solvers of a portfolio
+ * @version						v0.01b
+ * An append-only log, each solver reads it from its own cursor and
+ * skips its own clauses. Readers only take the lock when published
+ * has moved past their cursor.
+ ****************************************************************/
+class Clause_Exchange {
+  private:
+    mutex                       m;
+    vector<Lit>                 lits;           // clauses back to back
+    vector<int>                 ends;           // end of each clause in lits
+    vector<int>                 sources;        // solver of each clause
+    atomic<int>                 published;
+  public:
+    Clause_Exchange () : published(0) {};
+    void clear ();
+    void export_clause (int source, const vec<Lit> &clause);
+    bool import_clause (int reader, int &cursor, vec<Lit> &clause);
+};
+
+
 class SATTSP {
   private:
     Solver              *original_formula;
     Solver              *formula;
+    formula::CNF        cnf;
     TSP                 *graph;
     MST                 *mst;
     string              sat_filename, tsp_filename;
     int                 verbose_level;
-    bool                edge_theory, vertex_theory, lkh_theory, mst_theory, solving;
-    double              reduction_time, solver_time, theory_time;
+    bool                edge_theory, vertex_theory, lkh_theory, mst_theory, solving, incremental;
+    double              reduction_time, solver_time, theory_time, bound_time;
     int                 minisat_nDecisions, minisat_nLearnts;    
     int                 cb_minisat_error;
     int                 new_clauses;
     timeval             max_wall_time;
     int                 search_method, bdiv_parameter;
+    int                 probes;             // cost probes solved in parallel by solve_optimal()
+    bool                owns_graph;         // false for probes, which share their master's
+    atomic<bool>        interrupted;        // set to stop a running probe
+    int                 portfolio;          // solvers racing on each solve()
+    int                 share_size;         // longest learnt clause shared
+    vector<SATTSP*>     workers;
+    Clause_Exchange     shared_clauses;     // between the workers
+    Clause_Exchange     *exchange;          // of the master, NULL unless a worker
+    int                 worker_id, exchange_cursor;
+    int                 incumbent_fd;       // -1 unless publishing incumbents
+    timeval             search_start;
+    char                *compiled;          // mapped compiled instance, NULL if parsed
+    size_t              compiled_length;
 
     vector< vector<Theory*> >   var_theories;
     vector<Theory*>             theories;
     TSP_Theory                  *tsp_theory;
+    TSP_Theory                  *bound_theory;      // consulted before tsp_theory
 
     int                 soln_cost, tsp_cost_budget, subgraph_cost_budget;
     vector<int>         soln_tour;
@@ -90,6 +129,11 @@ class SATTSP {
     int                 solver_time_budget, usat_time_budget;
     int64_t             conflict_budget, propagation_budget;
 
+    // incremental mode: one selector literal per cost budget
+    vector<int>         budget_tsp_costs, budget_subgraph_costs;
+    vector<Lit>         budget_lits;
+    Lit                 budget_lit;
+
     static void minisat_trail_push_cb_wrapper (
         void* object_pointer, 
         const VMap<lbool> &assigns, 
@@ -111,11 +155,37 @@ class SATTSP {
     static bool minisat_within_budget_cb_wrapper (
         void* object_pointer);
 
+    static void minisat_export_clause_cb_wrapper (
+        void* object_pointer,
+        const vec<Lit> &clause);
+
+    static bool minisat_import_clause_cb_wrapper (
+        void* object_pointer,
+        vec<Lit> &clause);
+
+    struct Stats {
+        double          solver_time, theory_time, bound_time, reduction_time;
+        int             decisions, learnts, new_clauses;
+    };
+    Stats stats ();
+    void merge_stats (const vector<Stats> &deltas, double wall_time);
+    void export_clause (const vec<Lit> &clause);
+    void publish_incumbent ();
+
+    SATTSP ();
+    SATTSP (SATTSP *master);
+    bool map_compiled (string filename);
+    bool solve_probes (int verbose_level);
+    bool solve_portfolio (int tsp_cost_budget, int subgraph_cost_budget);
     void reset_formula();
+    void budget_assumptions(vec<Lit> &assumptions);
     string output_solution (const vector<int> &tour, const vector<bool> &assigns);
 
   public:
     SATTSP (string sat_filename, string tsp_filename, int verbose_level=-1);
+    ~SATTSP ();
+    static bool is_compiled (string filename);
+    bool compile (string filename);
 
     bool solve (int tsp_cost_budget, int subgraph_cost_budget);
     bool solve_optimal (int verbose_level=2);
@@ -135,6 +205,8 @@ class SATTSP {
     bool enable_edge_theory();
     bool enable_lkh_theory();
     bool enable_mst_theory();
+    bool enable_held_karp_theory(int iterations);
+    bool enable_incremental();
 
     bool set_bdiv_parameter(int x) {bdiv_parameter = x;}
 
@@ -150,6 +222,17 @@ class SATTSP {
     void assume_non_tsp_monotonic() {graph->assume_non_tsp_monotonic();};
     void set_lkh_parameters(string input_file) {graph->set_lkh_parameters(input_file);};
     void set_cb_interval(int x) {tsp_theory->cb_interval = x;};
+    void set_tsp_cache_size(int x) {graph->set_cache_size(x);};
+    void set_threads(int x) {graph->set_threads(x);};
+    void set_lkh_seeds(int x) {graph->set_lkh_seeds(x);};
+    void set_probes(int x) {probes = max(1, x);};
+    void set_portfolio(int x) {portfolio = max(1, x);};
+    void set_share_size(int x) {share_size = x;};
+    bool set_incumbent_output(string filename);
+    void set_distance_cache(int x) {graph->set_distance_cache(x);};
+    void set_property_cache(bool x) {graph->set_property_cache(x);};
+    bool set_subtour_encoding(string encoding) {return graph->set_subtour_encoding(encoding);};
+    void set_explain_solves(int x) {if (lkh_theory) ((Metric_TSP_Theory*) tsp_theory)->explain_solves = x;};
     string get_lkh_parameters() {return graph->get_lkh_parameters();};
     bool set_search_method(string method);
 };
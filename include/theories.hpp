@@ -33,6 +33,7 @@
 #include <iostream>
 #include <sstream>
 #include <vector>
+#include <list>
 #include <algorithm>
 #include <sys/time.h>
 #include <boost/format.hpp>
@@ -71,6 +72,7 @@ class Theory {
 //        bool conflict, conflict_checked;
 
     public:
+        virtual ~Theory () {};
         virtual void reset () {};
         virtual void print () = 0;
         virtual void minisat_trail_push_cb (
@@ -101,7 +103,10 @@ class TSP_Theory : public Theory {
         int tsp_cost_budget, subgraph_cost_budget;
         double theory_time;
         vector<int> soln_tour;
+        bool deferred;              // another theory already has a conflict, only follow the trail
+        TSP_Theory () : cb_interval(0), deferred(false) {};
         virtual void print () {printf("TSP_Theory\n");};
+        virtual bool conflicting () {return false;};
 };
 
 
@@ -144,11 +149,34 @@ class Edge_TSP_Theory : public TSP_Theory {
  ****************************************************************/
 class Metric_TSP_Theory : public TSP_Theory {
     private:
+        struct Core {
+            vector<int> vids;               // sorted
+            uint64_t signature;             // bit vid%64 set for each vid
+            int tsp_cost_budget, subgraph_cost_budget;
+        };
         TSP *graph;
         vector<int> soln_vids;
+        vector<int> tour_sizes;             // |soln_vids| each stacked tour covers
+        vector< vector<int> > tour_stack;   // feasible tours following the trail
+        list<Core> cores;                   // proven infeasible vertex sets, most recent first
+        vector<int> core_vids;              // cached core behind the current conflict
         bool conflict, conflict_checked;
+        int interval;                       // adaptive pushes per check (cb_interval == 0)
+        double check_latency;               // moving average over feasible checks
+        double conflict_rate;               // moving average over all checks
+
+        bool due ();
+        void check ();
+        bool find_core (const vector<int> &vids, vector<int> &core);
+        void add_core (const vector<int> &vids);
+        bool refuted (const vector<int> &vids, int &solves);
+        void minimize (vector<int> &vids);
 
     public:
+        int explain_solves;                 // LKH calls per conflict spent shrinking it, -1 to disable
+        int max_cores;
+        double latency_target;              // seconds, slower feasible checks are batched
+        int max_interval;
         Metric_TSP_Theory (TSP *graph, int verbose_level=-1);
         virtual void print () {printf("Metric_TSP_Theory\n");};
         virtual void reset ();
@@ -206,6 +234,50 @@ class MST_Theory : public TSP_Theory {
 };
 
 
+/************************************************************//**
+ * @brief	Held-Karp 1-tree lower bound on the selected vertices
+ * @version						v0.01b
+ * One bound per subgraph. Node penalties are kept across callbacks,
+ * so each push only takes a few subgradient steps. Needs a symmetric
+ * tsp_monotonic instance for the bound to hold for every superset.
+ ****************************************************************/
+class Held_Karp_Theory : public TSP_Theory {
+    private:
+        TSP *graph;
+        vector<int> soln_vids;
+        vector<int> subgraph_of;        // vid -> subgraph index
+        vector<int> bounds;             // per subgraph, 0 when stale
+        vector<double> penalty;         // per vid
+        vector<int> conflict_vids;
+        bool conflict, conflict_checked;
+
+        double one_tree (const vector<int> &vids, vector<int> &degree);
+        int ascent (const vector<int> &vids, int target);
+
+    public:
+        int iterations;                 // subgradient steps per push
+        Held_Karp_Theory (TSP *graph, int iterations=5, int verbose_level=-1);
+        virtual void print () {printf("Held_Karp_Theory\n");};
+        virtual void reset ();
+        virtual bool conflicting () {return conflict && !conflict_checked;};
+
+        virtual void minisat_trail_push_cb (
+            const VMap<lbool> &assigns, 
+            const vec<Lit>& trail, 
+            vec<Lit>& propagate_list);
+
+        virtual void minisat_trail_shrink_cb (
+            const VMap<lbool> &assigns, 
+            const vec<Lit> &trail, 
+            int amount);
+
+        virtual bool minisat_check_conflict_cb (
+            const VMap<lbool> &assigns, 
+            const vec<Lit> &trail, 
+            vec<Lit> &conflict_list);
+};
+
+
 /************************************************************//**
  * @brief
  * @version						v0.01b
@@ -0,0 +1,76 @@
+/********************************************************************************
+  Copyright 2017 Frank Imeson and Stephen L. Smith
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*********************************************************************************/
+
+
+#ifndef THREAD_POOL_H		// guard
+#define THREAD_POOL_H
+
+/********************************************************************************
+ * INCLUDE
+ ********************************************************************************/
+
+#include <vector>
+#include <queue>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+using namespace std;
+
+/********************************************************************************
+ * Prototypes
+ ********************************************************************************/
+
+class ThreadPool;
+
+
+/************************************************************//**
+ * @brief	Fixed set of worker threads for running independent jobs
+ * @version						v0.01b
+ * run() blocks until all jobs are done. The calling thread works on
+ * the jobs too, so a pool with no workers runs them serially and a
+ * job may itself call run() without deadlocking.
+ ****************************************************************/
+class ThreadPool {
+  private:
+    struct Batch {
+      int                         size;
+      const function<void(int)>*  job;
+      atomic<int>                 next, done;
+      mutex                       m;
+      condition_variable          finished;
+    };
+    vector<thread>                workers;
+    queue< shared_ptr<Batch> >    tasks;
+    mutex                         m;
+    condition_variable            wake;
+    bool                          stopping;
+
+    void worker ();
+    static void drain (Batch &batch);
+  public:
+    ThreadPool (int threads=1);
+    ~ThreadPool ();
+    int size () {return workers.size()+1;};
+    void run (int n, const function<void(int)> &job);
+};
+
+
+
+#endif
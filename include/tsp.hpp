@@ -30,13 +30,30 @@
 #include <sstream>
 #include <iostream>
 #include <vector>
+#include <stdint.h>
+#include <limits.h>
 #include <algorithm>
-
-#include <boost/regex.hpp>
+#include <list>
+#include <queue>
+#include <functional>
+#include <unordered_map>
+#include <string.h>
+#include <ctype.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <atomic>
+#if defined(__x86_64__) || defined(__i386__)
+  #define DISTANCE_SIMD
+  #include <immintrin.h>
+#endif
 
 #include "formula.hpp"
 #include "minisat/core/Solver.h"
 #include "minisat/core/Dimacs.h"
+#include "cbLKH.h"
+#include "thread_pool.hpp"
 
 using namespace std;
 using namespace Minisat;
@@ -45,6 +62,14 @@ using namespace Minisat;
  * Defs
  ********************************************************************************/
 #define INF 999999
+#define CACHE_LINE 64
+#define LAZY_DIMENSION 4096     // coordinate instances above this are not materialized
+#define CANDIDATE_DIMENSION 2048    // instances above this get no global LKH candidates
+#define CANDIDATES_PER_NODE 30
+#define CANDIDATE_TOP_UP 6          // fewest candidates per node handed to LKH, twin included
+
+enum { WEIGHT_EXPLICIT, WEIGHT_EUC_2D, WEIGHT_GEO, WEIGHT_ATT, WEIGHT_CEIL_2D };
+enum SUBTOUR_ENCODING { REACHABILITY_ENCODING, MTZ_ENCODING, BITVECTOR_ENCODING };
 
 
 /********************************************************************************
@@ -52,6 +77,9 @@ using namespace Minisat;
  ********************************************************************************/
 
 class TSP;
+class TSP_Cache;
+class Weight_Matrix;
+class Bit_Matrix;
 class MST;
 
 int parse_input(string filename, TSP &graph);
@@ -59,13 +87,160 @@ int parse_input(string filename, TSP &graph);
 
 
 
+/************************************************************//**
+ * @brief	n x n edge weights, row-major with cache line aligned rows
+ * @version						v0.01b
+ * Weights are stored as int32 while the instance is parsed. compact()
+ * switches to int16 when every finite weight fits, in which case
+ * weights >= INF are stored as INT16_MAX and read back as INF.
+ *
+ * Coordinate instances may instead stay lazy: only the coordinates
+ * are kept (radians for GEO) and weights are computed on demand,
+ * through a small per-thread cache of rows if set_row_cache() > 0.
+ *
+ * map() uses a table stored elsewhere (a compiled instance) in place,
+ * it is never freed and must outlive the matrix.
+ ****************************************************************/
+class Weight_Matrix {
+  private:
+    int             n, stride;
+    bool            wide, mapped;
+    void*           data;
+    int             kind;
+    vector<double>  x, y;
+    int             cache_rows, cache_id;
+    Weight_Matrix (const Weight_Matrix&);
+    Weight_Matrix& operator= (const Weight_Matrix&);
+    int  distance (int i, int j) const;
+    int  lazy_weight (int i, int j) const;
+  public:
+    Weight_Matrix () : n(0), stride(0), wide(true), mapped(false), data(NULL), kind(WEIGHT_EXPLICIT), cache_rows(0), cache_id(0) {};
+    ~Weight_Matrix () {if (!mapped) free(data);};
+    void resize (int n, int value=-1);
+    void clear () {resize(0);};
+    bool compact ();
+    void set_coordinates (int kind, const vector< vector<double> > &coords);
+    void map (int n, int kind, int width, int stride, void *table, const double *x, const double *y);
+    void materialize ();
+    void compute_row (int i, int32_t *row) const;
+    const int32_t* row (int i, int32_t *buffer) const;
+    void set_row_cache (int rows) {cache_rows = max(rows, 0);};
+    bool lazy () const {return data == NULL && kind != WEIGHT_EXPLICIT;};
+    int  size () const {return n;};
+    int  width () const {return wide ? 32 : 16;};
+    int  weight_kind () const {return kind;};
+    int  row_stride () const {return stride;};
+    const void* table () const {return data;};
+    const vector<double>& x_coords () const {return x;};
+    const vector<double>& y_coords () const {return y;};
+    int  operator() (int i, int j) const {
+      if (data == NULL)
+        return lazy_weight(i,j);
+      size_t k = size_t(i)*stride + j;
+      if (wide)
+        return ((const int32_t*) data)[k];
+      int16_t w = ((const int16_t*) data)[k];
+      return w == INT16_MAX ? INF : w;
+    };
+    void set (int i, int j, int w);
+};
+
+
+/************************************************************//**
+ * @brief	n x n bitset, one 64 bit word aligned row per vertex
+ * @version						v0.01b
+ * complete() describes the complete graph without self loops and
+ * stores no bits until the first set().
+ ****************************************************************/
+class Bit_Matrix {
+  private:
+    int                 n, words;
+    bool                full;
+    vector<uint64_t>    bits;
+  public:
+    Bit_Matrix (int n=0) {resize(n);};
+    void resize (int n) {this->n = n; words = (n+63)/64; full = false; bits.assign(size_t(n)*words, 0);};
+    void clear () {resize(0);};
+    void complete (int n) {this->n = n; words = (n+63)/64; full = true; vector<uint64_t>().swap(bits);};
+    int  size () const {return n;};
+    bool complete () const {return full;};
+    const uint64_t* row (int i) const {return &bits[size_t(i)*words];};
+    void assign (int n, const uint64_t *rows) {resize(n); bits.assign(rows, rows + size_t(n)*words);};
+    bool operator() (int i, int j) const {
+      if (full)
+        return i != j;
+      return (bits[size_t(i)*words + j/64] >> (j%64)) & 1;
+    };
+    void set (int i, int j, bool b) {
+      if (full) {
+        // fall back to explicit bits
+        bits.assign(size_t(n)*words, ~uint64_t(0));
+        full = false;
+        for (int k=0; k<n; k++)
+          set(k, k, false);
+      }
+      uint64_t &word = bits[size_t(i)*words + j/64];
+      if (b)
+        word |= (uint64_t(1) << (j%64));
+      else
+        word &= ~(uint64_t(1) << (j%64));
+    };
+};
+
+
+/************************************************************//**
+ * @brief	LRU cache of tours keyed on a (sorted) vertex subset
+ * @version						v0.01b
+ * LKH is a heuristic, so a failed budget only answers queries until
+ * the next new_epoch(), tours are kept.
+ ****************************************************************/
+class TSP_Cache {
+  private:
+    struct Hash {
+      size_t operator() (const vector<int> &key) const;
+    };
+    struct Entry {
+      vector<int> key;          // sorted vids
+      vector<int> tour;         // best tour found (empty if none)
+      int cost;                 // cost of tour
+      int infeasible_cost;      // largest budget LKH failed to meet (-1 if none)
+      int infeasible_epoch;     // in which infeasible_cost was recorded
+    };
+    int capacity, epoch;
+    list<Entry> entries;        // most recently used first
+    unordered_map<vector<int>, list<Entry>::iterator, Hash> index;
+    Entry& touch(const vector<int> &key);
+  public:
+    TSP_Cache (int capacity=10000) : capacity(capacity), epoch(0), hits(0), misses(0) {};
+    int hits, misses;
+    void set_capacity(int x);
+    bool lookup(const vector<int> &key, const int &max_cost, vector<int> &soln_tour, int &soln_cost, bool &feasible);
+    void insert_tour(const vector<int> &key, const vector<int> &tour, const int &cost);
+    void insert_infeasible(const vector<int> &key, const int &max_cost);
+    void new_epoch() {epoch++;};
+};
+
+
 class TSP {
   private:
     int edge_var_offset;
+    int subtour_encoding;         // of tsp2cnf(), see set_subtour_encoding()
     int _metric, _symmetric, _tsp_monotonic;
     string lkh_parameters;
+    int seeds;                    // LKH runs per call, in parallel on the pool
+    ThreadPool *pool;
+    mutex lkh_mutex;              // guards cache and rand() in LKH()
+    int _candidates;              // global LKH candidates: -1 not created, 0 unavailable, 1 ready
+    vector<int> candidate_pi;     // per node of the transformed ATSP, vid v is node v+1, its twin v+1+size()
+    vector<int> candidate_sets;   // as written by LKH_CreateCandidates
+    void create_candidates();
+    void reachability2cnf(Solver* solver, const vector<Lit> &edge_lits, const vector<Lit> &roots);
+    void ordering2cnf(Solver* solver, const vector<Lit> &edge_lits, const vector<Lit> &roots, bool successor);
+    int  cached_property(const string &key);
+    void cache_property(const string &key, int value);
+    bool restrict_candidates(const vector<int> &sorted_vids, const vector<int> &matrix, vector<int> &pi, vector<int> &candidates);
   public:
-    TSP () : _metric(-1), _symmetric(-1), _tsp_monotonic(-1), tsp_cost_budget(INF), subgraph_cost_budget(INF) {
+    TSP () : subtour_encoding(REACHABILITY_ENCODING), _metric(-1), _symmetric(-1), _tsp_monotonic(-1), seeds(1), pool(new ThreadPool(1)), _candidates(-1), file_hash(0), property_cache(true), tsp_cost_budget(INF), subgraph_cost_budget(INF) {
       lkh_parameters  = "PRECISION         = 10\n";
       lkh_parameters += "MOVE_TYPE         = 5\n";
       lkh_parameters += "PATCHING_C        = 3\n";
@@ -74,14 +249,18 @@ class TSP {
       lkh_parameters += "TRACE_LEVEL       = 0\n";
     };
     string name, type;
+    string filename;              // instance file, keys the sidecar property cache
+    uint64_t file_hash;
+    bool property_cache;          // read and write filename + ".props"
     int tsp_cost_budget, subgraph_cost_budget;
-    vector< vector<bool> >  adjacency;
-    vector< vector<int> > edge_weight;
+    Bit_Matrix adjacency;
+    Weight_Matrix edge_weight;
     vector< vector<int> > vid_incoming_vars;
     vector< vector<int> > vid_outgoing_vars;
     vector<vector<int>> gtsp_sets, subgraphs;
     vector<int> level00_vars;
     vector<int> theory_vars;
+    TSP_Cache cache;
 
     int size () {return edge_weight.size();};
     int tsp2cnf (Solver* solver);
@@ -94,8 +273,13 @@ class TSP {
     int eid_cost (int eid);
     bool operator() (int eid00, int eid01) {return eid_cost(eid00) > eid_cost(eid01);};
     int  lit_cost (const Lit &lit);
-    bool LKH(const vector<int> &vids, const int &max_cost, vector<int> &soln_tour, int &soln_cost);
-    bool solve(const vector<int> &vids, const int tsp_cost_budget, const int subgraph_cost_budget, vector<int> &soln_tour, int &soln_cost);
+    bool LKH(const vector<int> &vids, const int &max_cost, vector<int> &soln_tour, int &soln_cost, const atomic<int> *cancel=NULL, const vector<int> *initial_tour=NULL);
+    bool solve(const vector<int> &vids, const int tsp_cost_budget, const int subgraph_cost_budget, vector<int> &soln_tour, int &soln_cost, const vector<int> *initial_tour=NULL);
+    bool extend(const vector<int> &tour, const vector<int> &vids, const int tsp_cost_budget, const int subgraph_cost_budget, vector<int> &soln_tour);
+    int  cycle_cost(const vector<int> &tour);
+    void cheapest_insertion(vector<int> &tour, const int vid);
+    void local_search(vector<int> &tour);
+    int  one_tree_bound(const vector<int> &vids);
     bool metric();
     bool symmetric();
     bool tsp_monotonic();
@@ -107,31 +291,60 @@ class TSP {
     void assume_non_tsp_monotonic() {_tsp_monotonic = 0;};
     void set_lkh_parameters(string input_file);
     string get_lkh_parameters();
+    void set_cache_size(int x) {cache.set_capacity(x);};
+    void forget_lkh_failures() {lock_guard<mutex> lock(lkh_mutex); cache.new_epoch();};
+    void set_threads(int x) {delete pool; pool = new ThreadPool(x);};
+    int  threads() {return pool->size();};
+    void set_lkh_seeds(int x) {seeds = max(1, x);};
+    int  lkh_seeds() {return seeds;};
+    void set_distance_cache(int x) {edge_weight.set_row_cache(x);};
+    void set_property_cache(bool x) {property_cache = x;};
+    bool set_subtour_encoding(string encoding);
     bool feasible(const vector<int> &soln_tour, const int tsp_cost_budget, const int subgraph_cost_budget);
     void split_vids(const vector<int> &vids, vector<vector<int>> &subgraph_vids);
     bool get_tour_cost(const vector<int> &tour, int &tsp_cost, int &max_subgraph_cost);
 };
 
 
+/************************************************************//**
+ * @brief	Minimum spanning tree over a growing vertex subset
+ * @version						v0.01b
+ * insert() updates the tree in O(k) for k tree vertices and records
+ * every replaced edge in an undo log, so undo() restores the tree
+ * exactly as it was before the last insert().
+ ****************************************************************/
 class MST {
   private:
-    TSP*                    graph;
-    int                     _size;
-    int                     _cost;
-    vector<bool>            subset;
-    vector< vector<bool> >  adjacency;
+    struct Tree_Edge {
+      int from, to, cost;
+      Tree_Edge () : from(-1), to(-1), cost(0) {};
+      Tree_Edge (int from, int to, int cost) : from(from), to(to), cost(cost) {};
+    };
+    struct Frame {
+      int log_size, cost;
+    };
+    TSP*                          graph;
+    int                           _cost;
+    vector<bool>                  subset;
+    vector<int>                   vids;         // tree vertices in insertion order
+    vector<Tree_Edge>             edges;        // |vids|-1 tree edges
+    vector< pair<int,Tree_Edge> > undo_log;     // (slot, replaced edge)
+    vector<Frame>                 frames;       // one per undoable insert
 
-    int                     z_vid;                // new vertex to insert
-    vector<bool>            new_subset;
-    vector< vector<bool> >  new_adjacency;
+    // scratch space, sized once for the whole graph
+    vector<int>                   head, next, slot, parent, parent_slot, stack;
+    vector<Tree_Edge>             best;
 
-    void                    _insert(int r_vid, int &t_eid);
+    void                          reserve ();
+    void                          prim_dense (const vector<int> &subset);
+    bool                          prim_sparse (const vector<int> &subset);
   public:
     MST (TSP* graph);
     MST (TSP* graph, const vector<int> subset);
     int insert(int vid);
+    void undo();
     int adjacent (int vid, vector<int> &list);
-    int size () {return _size;};
+    int size () {return vids.size();};
     int cost() {return _cost;};
 
 
@@ -48,7 +48,7 @@ int main(int argc, char **argv) {
     bool      edge_theory(false), lkh_theory(true), mst_theory(false), linear_search(false);
     int       num_trials, max_time(-1), max_usat_time(-1), verbose_level(-1), bin_search_divider(10);
     double    max_cost;
-    string    tsp_filename, sat_filename, output_filename;
+    string    tsp_filename, sat_filename, output_filename, subtour_encoding;
     int64_t   conflict_budget, propagation_budget;
 
     /************************************************************
@@ -71,6 +71,8 @@ int main(int argc, char **argv) {
                                                     "(-1 for unlimited)")
     ("edge",        po::value(&edge_theory)->zero_tokens(),
                                                     "enable EDGE theory")
+    ("subtour",     po::value<string>(&subtour_encoding)->default_value("reachability"),
+                                                    "EDGE theory subtour encoding: reachability, mtz, bitvector")
     ("lkh",         po::value(&lkh_theory)->zero_tokens(),
                                                     "enable LKH theory")
     ("mst",         po::value(&mst_theory)->zero_tokens(),
@@ -152,6 +154,8 @@ int main(int argc, char **argv) {
     if (non_metric) problem.assume_non_metric();
     if (symmetric) problem.assume_symmetric();
     if (non_symmetric) problem.assume_non_symmetric();
+    if (!problem.set_subtour_encoding(subtour_encoding))
+        return 0;
     if (edge_theory) problem.enable_edge_theory();
     if (lkh_theory) {
     if (!problem.enable_lkh_theory()) {
@@ -42,10 +42,10 @@ int main(int argc, char **argv) {
      * Setup
      ******************************/
     srand ( time(NULL) );
-    bool      brute(false), print_lkh_params(false), tsp_monotonic(false), non_tsp_monotonic(false);
-    int       max_time(-1), max_usat_time(-1), verbose_level(-1), bdiv_parameter(10), cb_interval(1);
+    bool      brute(false), print_lkh_params(false), no_property_cache(false), tsp_monotonic(false), non_tsp_monotonic(false), incremental(false);
+    int       max_time(-1), max_usat_time(-1), verbose_level(-1), bdiv_parameter(10), cb_interval(0), tsp_cache(10000), threads(1), lkh_seeds(1), probes(1), portfolio(1), share_size(8), distance_cache(0), held_karp(0), explain(3);
     int       max_tsp_cost, max_subgraph_cost;
-    string    tsp_filename, sat_filename, output_filename, lkh_parameter_filename, search_method;
+    string    tsp_filename, sat_filename, output_filename, compile_filename, incumbent_filename, lkh_parameter_filename, search_method;
     int64_t   conflict_budget, propagation_budget;
 
     /************************************************************
@@ -61,6 +61,14 @@ int main(int argc, char **argv) {
       po::value<string>(&output_filename)->default_value(""),
       "output filename"
     )
+    ( "compile",
+      po::value<string>(&compile_filename),
+      "write the instance to this file for faster loading (as the only input file) and exit"
+    )
+    ( "incumbent",
+      po::value<string>(&incumbent_filename),
+      "truncate this file and write each improved solution to it as a line of JSON"
+    )
     ( "brute", 
       po::value(&brute)->zero_tokens(),
      "enable brute mode (cb_interval > |V|)"
@@ -90,8 +98,52 @@ int main(int argc, char **argv) {
       "set binary search divider"
     )
     ( "cb_interval",
-      po::value<int>(&cb_interval)->default_value(1),
-      "tsp callback interval"
+      po::value<int>(&cb_interval)->default_value(0),
+      "tsp callback interval (0 for adaptive)"
+    )
+    ( "probes",
+      po::value<int>(&probes)->default_value(1),
+      "cost probes solved in parallel, each in its own solver"
+    )
+    ( "portfolio",
+      po::value<int>(&portfolio)->default_value(1),
+      "diversified solvers racing on each cost probe, sharing clauses"
+    )
+    ( "share_size",
+      po::value<int>(&share_size)->default_value(8),
+      "longest learnt clause shared within the portfolio"
+    )
+    ( "incremental",
+      po::value(&incremental)->zero_tokens(),
+      "reuse one solver (and its learnt clauses) across cost probes"
+    )
+    ( "tsp_cache",
+      po::value<int>(&tsp_cache)->default_value(10000),
+      "max number of vertex subsets with cached tours (0 to disable)"
+    )
+    ( "threads",
+      po::value<int>(&threads)->default_value(1),
+      "number of threads for solving subgraphs in parallel"
+    )
+    ( "lkh_seeds",
+      po::value<int>(&lkh_seeds)->default_value(1),
+      "LKH runs with different seeds per call, the first success stops the rest"
+    )
+    ( "held_karp",
+      po::value<int>(&held_karp)->default_value(0),
+      "Held-Karp ascent steps per vertex for a 1-tree bound ahead of LKH (0 to disable)"
+    )
+    ( "explain",
+      po::value<int>(&explain)->default_value(3),
+      "LKH calls spent shrinking each conflict (0 for bounds only, -1 to disable)"
+    )
+    ( "distance_cache",
+      po::value<int>(&distance_cache)->default_value(0),
+      "rows of computed distances cached per thread for large coordinate instances"
+    )
+    ( "no_property_cache",
+      po::value(&no_property_cache)->zero_tokens(),
+      "do not read or write the tsp_file.props cache of detected graph properties"
     )
     ( "conflicts",
       po::value<int64_t>(&conflict_budget)->default_value(-1),
@@ -146,7 +198,9 @@ int main(int argc, char **argv) {
         return 0;
     }
     
-    if (vm["input"].as< vector<string> >().size() == 1) {
+    if (vm["input"].as< vector<string> >().size() == 1 && SATTSP::is_compiled(vm["input"].as< vector<string> >()[0])) {
+        sat_filename = vm["input"].as< vector<string> >()[0];
+    } else if (vm["input"].as< vector<string> >().size() == 1) {
         sat_filename = vm["input"].as< vector<string> >()[0] + ".cnf";
         tsp_filename = vm["input"].as< vector<string> >()[0] + ".tsp";
     } else if (vm["input"].as< vector<string> >().size() == 2) {
@@ -157,13 +211,17 @@ int main(int argc, char **argv) {
         return 0;
     }
 
-    if (verbose_level >= 1) {
+    if (verbose_level >= 1 && tsp_filename.empty()) {
+        printf("input compiled: %s\n", sat_filename.c_str());
+    } else if (verbose_level >= 1) {
         printf("input cnf: %s\n", sat_filename.c_str());
         printf("input tsp: %s\n", tsp_filename.c_str());
     }
 
     // setup problem instance
     SATTSP problem(sat_filename, tsp_filename, verbose_level);
+    if (vm.count("compile"))
+        return problem.compile(compile_filename) ? 0 : 1;
     if (verbose_level >= 1) {
         printf("setup...\n");
     }
@@ -173,19 +231,35 @@ int main(int argc, char **argv) {
         problem.set_search_method("linear");
         problem.set_bdiv_parameter(999999);
     }
+    if (no_property_cache)
+        problem.set_property_cache(false);
     if (tsp_monotonic)
         problem.assume_tsp_monotonic();
     if (!problem.enable_lkh_theory()) {
         printf("Error: could not enable LKH theory. Is the instance tsp_monotonic?\n");
         return 0;
     }
+    if (held_karp > 0 && !problem.enable_held_karp_theory(held_karp))
+        printf("Warning: Held-Karp theory needs a symmetric tsp_monotonic instance, disabled\n");
     problem.setConfBudget(conflict_budget);
     problem.setPropBudget(propagation_budget);
     problem.set_cb_interval(cb_interval);
+    problem.set_tsp_cache_size(tsp_cache);
+    problem.set_threads(threads);
+    problem.set_lkh_seeds(lkh_seeds);
+    problem.set_probes(probes);
+    problem.set_portfolio(portfolio);
+    problem.set_share_size(share_size);
+    problem.set_distance_cache(distance_cache);
+    problem.set_explain_solves(explain);
+    if (incremental)
+        problem.enable_incremental();
     if (max_usat_time > 0)
         problem.setUsatTimeBudget(max_usat_time);
     if (max_time > 0)
         problem.setTimeBudget(max_time);
+    if (vm.count("incumbent") && !problem.set_incumbent_output(incumbent_filename))
+        return 1;
     if (vm.count("input_lkh_params")) {
         problem.set_lkh_parameters(lkh_parameter_filename);
     }
@@ -596,5 +596,66 @@ string Formula::str (string prefix) {
 
 
 
+/************************************************************//**
+ * @brief	            Append a clause to the snapshot
+ * @version						v0.01b
+ ****************************************************************/
+bool CNF::addClause_ (vec<Lit> &clause) {
+    for (int i=0; i<clause.size(); i++)
+        lits.push(clause[i]);
+    clause_ends.push(lits.size());
+    return true;
+}
+
+
+
+/************************************************************//**
+ * @brief	            View num_clauses clauses stored elsewhere
+ * @version						v0.01b
+ ****************************************************************/
+void CNF::map (int num_vars, int num_clauses, const Lit *lits, const int *clause_ends) {
+    this->num_vars  = num_vars;
+    this->lits.clear(true);
+    this->clause_ends.clear(true);
+    mapped_lits     = lits;
+    mapped_ends     = clause_ends;
+    mapped_clauses  = num_clauses;
+}
+
 
 
+/************************************************************//**
+ * @brief	            Copy the snapshot into a (fresh) solver
+ * @version						v0.01b
+ ****************************************************************/
+bool CNF::load (Solver &solver) const {
+    while (solver.nVars() < num_vars)
+        solver.newVar();
+    bool ok(true);
+    vec<Lit> clause;
+    const Lit *lits = clauseLits();
+    const int *ends = clauseEnds();
+    for (int i=0, begin=0; i<nClauses(); begin=ends[i++]) {
+        clause.clear();
+        for (int j=begin; j<ends[i]; j++)
+            clause.push(lits[j]);
+        ok &= solver.addClause_(clause);
+    }
+    return ok;
+}
+
+
+
+/************************************************************//**
+ * @brief	            Copy the snapshot into another one
+ * @version						v0.01b
+ * A mapped snapshot is copied as a view of the same clauses.
+ ****************************************************************/
+void CNF::copyTo (CNF &copy) const {
+    copy.num_vars = num_vars;
+    lits.copyTo(copy.lits);
+    clause_ends.copyTo(copy.clause_ends);
+    copy.mapped_lits    = mapped_lits;
+    copy.mapped_ends    = mapped_ends;
+    copy.mapped_clauses = mapped_clauses;
+}
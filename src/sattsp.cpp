@@ -34,54 +34,139 @@
 
 
 
+/************************************************************//**
+ * @brief	
+ * @version						v0.01b
+ ****************************************************************/
+void Clause_Exchange::clear ()
+{
+    lock_guard<mutex> lock(m);
+    lits.clear();
+    ends.clear();
+    sources.clear();
+    published = 0;
+}
+
+
+/************************************************************//**
+ * @brief	
+ * @version						v0.01b
+ ****************************************************************/
+void Clause_Exchange::export_clause (int source, const vec<Lit> &clause)
+{
+    lock_guard<mutex> lock(m);
+    for (int i=0; i<clause.size(); i++)
+        lits.push_back(clause[i]);
+    ends.push_back(lits.size());
+    sources.push_back(source);
+    published = ends.size();
+}
+
+
+/************************************************************//**
+ * @brief	                    Next clause after cursor not from reader
+ * @version						v0.01b
+ ****************************************************************/
+bool Clause_Exchange::import_clause (int reader, int &cursor, vec<Lit> &clause)
+{
+    if (cursor >= published)
+        return false;
+    lock_guard<mutex> lock(m);
+    while (cursor < ends.size() && sources[cursor] == reader)
+        cursor++;
+    if (cursor >= ends.size())
+        return false;
+    clause.clear();
+    for (int i=(cursor > 0 ? ends[cursor-1] : 0); i<ends[cursor]; i++)
+        clause.push(lits[i]);
+    cursor++;
+    return true;
+}
+
+
 /************************************************************//**
  * @brief	
  * @version						v0.01b
  * TODO: make INF an input argument
  ****************************************************************/
-SATTSP::SATTSP(string sat_filename, string tsp_filename, int verbose_level)
-  : sat_filename(sat_filename)
-  , tsp_filename(tsp_filename)
-  , verbose_level(verbose_level)
+SATTSP::SATTSP()
+  : verbose_level(-1)
+  , edge_theory(false)
+  , vertex_theory(false)
+  , lkh_theory(false)
+  , mst_theory(false)
+  , incremental(false)
   , reduction_time(0)
   , solver_time(0)
+  , theory_time(0)
+  , bound_time(0)
+  , minisat_nDecisions(0)
+  , minisat_nLearnts(0)
+  , cb_minisat_error(-1)
+  , new_clauses(0)
+  , search_method(BINARY)
+  , bdiv_parameter(10)
+  , probes(1)
+  , owns_graph(true)
+  , interrupted(false)
+  , portfolio(1)
+  , share_size(8)
+  , exchange(NULL)
+  , worker_id(0)
+  , exchange_cursor(0)
+  , incumbent_fd(-1)
+  , compiled(NULL)
+  , compiled_length(0)
+  , tsp_theory(NULL)
+  , bound_theory(NULL)
   , soln_cost(999999)
   , tsp_cost_budget(999999)
   , subgraph_cost_budget(999999)
-  , conflict_budget(-1)
-  , propagation_budget(-1)
   , clause_checked(false)
-  , eid_conflict(false)
   , vid_conflict(false)
+  , eid_conflict(false)
   , mst_valid(true)
-  , edge_theory(false)
-  , vertex_theory(false)
-  , lkh_theory(false)
-  , mst_theory(false)
-  , tsp_theory(NULL)
-  , cb_minisat_error(-1)
   , solver_time_budget(-1)
   , usat_time_budget(-1)
-  , new_clauses(0)
-  , bdiv_parameter(10)
-  , minisat_nDecisions(0)
-  , minisat_nLearnts(0)
-  , search_method(BINARY)
+  , conflict_budget(-1)
+  , propagation_budget(-1)
+  , budget_lit(lit_Undef)
 {
+}
+
+
+/************************************************************//**
+ * @brief	
+ * @version						v0.01b
+ * sat_filename may instead name a compiled instance (see compile()),
+ * tsp_filename is then ignored.
+ ****************************************************************/
+SATTSP::SATTSP(string sat_filename, string tsp_filename, int verbose_level)
+  : SATTSP()
+{
+  this->sat_filename  = sat_filename;
+  this->tsp_filename  = tsp_filename;
+  this->verbose_level = verbose_level;
   formula           = new Solver();
   original_formula  = new Solver();
   graph             = new TSP();
 
   time_t tic = time(0);
   try {
-    gzFile cnf_file;
-    cnf_file = gzopen(sat_filename.c_str(), "rb");
-    parse_DIMACS(cnf_file, *original_formula);
-    gzclose(cnf_file);
-    cnf_file = gzopen(sat_filename.c_str(), "rb");
-    parse_DIMACS(cnf_file, *formula);
-    gzclose(cnf_file);
-    parse_input(tsp_filename, *graph);
+    if (is_compiled(sat_filename)) {
+      if (!map_compiled(sat_filename)) {
+        cerr << "error: could not load " << sat_filename << '\n';
+        exit(1);
+      }
+    } else {
+      gzFile cnf_file;
+      cnf_file = gzopen(sat_filename.c_str(), "rb");
+      parse_DIMACS(cnf_file, cnf);
+      gzclose(cnf_file);
+      parse_input(tsp_filename, *graph);
+    }
+    cnf.load(*original_formula);
+    cnf.load(*formula);
   } catch(exception& e) {
     cerr << "error: " << e.what() << '\n';
   }
@@ -96,6 +181,341 @@ SATTSP::SATTSP(string sat_filename, string tsp_filename, int verbose_level)
 }
 
 
+/************************************************************//**
+ * @brief	                    Independent solver for the cost probes of master
+ * @version						v0.01b
+ * The probe shares the graph (and its LKH cache) of master but has
+ * its own formula and theories, so it may solve for a different cost
+ * budget on another thread. Edge theory rewrites the graph and is not
+ * supported.
+ ****************************************************************/
+SATTSP::SATTSP(SATTSP *master)
+  : SATTSP()
+{
+  assert (!master->edge_theory);
+  sat_filename        = master->sat_filename;
+  tsp_filename        = master->tsp_filename;
+  verbose_level       = master->verbose_level;
+  owns_graph          = false;
+  graph               = master->graph;
+  original_formula    = master->original_formula;
+  master->cnf.copyTo(cnf);
+  formula             = new Solver();
+  mst                 = new MST(graph);
+  conflict_budget     = master->conflict_budget;
+  propagation_budget  = master->propagation_budget;
+  solver_time_budget  = master->solver_time_budget;
+  usat_time_budget    = master->usat_time_budget;
+  incremental         = master->incremental;
+
+  if (master->lkh_theory) {
+    enable_lkh_theory();
+    Metric_TSP_Theory *theory = (Metric_TSP_Theory*) tsp_theory;
+    Metric_TSP_Theory *master_theory = (Metric_TSP_Theory*) master->tsp_theory;
+    theory->explain_solves = master_theory->explain_solves;
+    theory->latency_target = master_theory->latency_target;
+    theory->max_interval   = master_theory->max_interval;
+  } else if (master->mst_theory) {
+    enable_mst_theory();
+  }
+  if (tsp_theory != NULL)
+    tsp_theory->cb_interval = master->tsp_theory->cb_interval;
+  if (master->bound_theory != NULL)
+    enable_held_karp_theory(((Held_Karp_Theory*) master->bound_theory)->iterations);
+}
+
+
+/************************************************************//**
+ * @brief	
+ * @version						v0.01b
+ ****************************************************************/
+SATTSP::~SATTSP()
+{
+  for (int i=0; i<workers.size(); i++)
+    delete workers[i];
+  if (incumbent_fd >= 0)
+    close(incumbent_fd);
+  for (int i=0; i<theories.size(); i++)
+    delete theories[i];
+  delete mst;
+  delete formula;
+  if (owns_graph) {
+    delete original_formula;
+    delete graph;
+    if (compiled != NULL)
+      munmap(compiled, compiled_length);
+  }
+}
+
+
+/************************************************************//**
+ * @brief	Layout of a compiled instance
+ * @version						v0.01b
+ * The header is followed by its sections, each at a CACHE_LINE
+ * aligned offset and in native byte order. Lists of lists (subgraphs
+ * and GTSP sets) are stored as their count, then the size and the
+ * elements of each list. The weight table is stored as laid out in
+ * memory, and left out for lazy coordinate instances.
+ ****************************************************************/
+#define COMPILED_MAGIC      "cbTSPbin"
+#define COMPILED_VERSION    1
+
+struct Compiled_Header {
+    enum {LITS, ENDS, WEIGHTS, X, Y, ADJACENCY, SUBGRAPHS, GTSP_SETS, STRINGS, SECTIONS};
+    char        magic[8];
+    int32_t     version, byte_order;
+    int32_t     num_vars, num_clauses;
+    int32_t     n, kind, width, stride, adjacency_full;
+    int32_t     tsp_cost_budget, subgraph_cost_budget;
+    int32_t     padding;
+    uint64_t    tsp_hash;               // keys the sidecar property cache
+    uint64_t    offset[SECTIONS], length[SECTIONS];
+};
+
+static void flatten (const vector< vector<int> > &lists, vector<int32_t> &flat)
+{
+    flat.assign(1, lists.size());
+    for (int i=0; i<lists.size(); i++) {
+        flat.push_back(lists[i].size());
+        flat.insert(flat.end(), lists[i].begin(), lists[i].end());
+    }
+}
+
+static bool unflatten (const int32_t *flat, uint64_t length, int n, vector< vector<int> > &lists)
+{
+    const int32_t *end = flat + length/sizeof(int32_t);
+    lists.clear();
+    if (flat == end)
+        return true;
+    if (*flat < 0 || *flat > end-flat-1)
+        return false;
+    lists.resize(*flat++);
+    for (int i=0; i<lists.size(); i++) {
+        if (flat >= end || *flat < 0 || end-flat-1 < *flat)
+            return false;
+        lists[i].assign(flat+1, flat+1+*flat);
+        flat += 1 + *flat;
+        for (int j=0; j<lists[i].size(); j++) {
+            if (lists[i][j] < 0 || lists[i][j] >= n)
+                return false;
+        }
+    }
+    return true;
+}
+
+
+/************************************************************//**
+ * @brief	Whether filename is a compiled instance
+ * @version						v0.01b
+ ****************************************************************/
+bool SATTSP::is_compiled (string filename)
+{
+    char magic[8];
+    FILE *file = fopen(filename.c_str(), "rb");
+    if (file == NULL)
+        return false;
+    bool compiled = (fread(magic, 1, 8, file) == 8 && memcmp(magic, COMPILED_MAGIC, 8) == 0);
+    fclose(file);
+    return compiled;
+}
+
+
+/************************************************************//**
+ * @brief	Write the parsed instance for map_compiled()
+ * @version						v0.01b
+ * Written to a temporary file that is renamed over filename, so
+ * processes still mapping the old file are unaffected.
+ ****************************************************************/
+bool SATTSP::compile (string filename)
+{
+    static_assert(sizeof(Lit) == sizeof(int32_t), "Lit is stored as int32");
+    typedef Compiled_Header H;
+    Weight_Matrix &weights = graph->edge_weight;
+    Bit_Matrix &adjacency = graph->adjacency;
+
+    H header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, COMPILED_MAGIC, 8);
+    header.version              = COMPILED_VERSION;
+    header.byte_order           = 0x01020304;
+    header.num_vars             = cnf.nVars();
+    header.num_clauses          = cnf.nClauses();
+    header.n                    = weights.size();
+    header.kind                 = weights.weight_kind();
+    header.width                = weights.width();
+    header.stride               = weights.row_stride();
+    header.adjacency_full       = adjacency.complete();
+    header.tsp_cost_budget      = graph->tsp_cost_budget;
+    header.subgraph_cost_budget = graph->subgraph_cost_budget;
+    header.tsp_hash             = graph->file_hash;
+
+    vector<int32_t> subgraphs, gtsp_sets;
+    flatten(graph->subgraphs, subgraphs);
+    flatten(graph->gtsp_sets, gtsp_sets);
+    string strings = graph->name + '\0' + graph->type + '\0' + sat_filename + '\0' + tsp_filename + '\0';
+    uint64_t n = header.n, words = (n+63)/64;
+    bool bits = !adjacency.complete() && n > 0;
+
+    const void *data[H::SECTIONS] = {
+        cnf.clauseLits(), cnf.clauseEnds(), weights.table(),
+        weights.x_coords().data(), weights.y_coords().data(), bits ? adjacency.row(0) : NULL,
+        subgraphs.data(), gtsp_sets.data(), strings.data()};
+    uint64_t length[H::SECTIONS] = {
+        cnf.nLits()*sizeof(Lit), cnf.nClauses()*sizeof(int32_t),
+        weights.table() ? n*header.stride*(header.width/8) : 0,
+        weights.x_coords().size()*sizeof(double), weights.y_coords().size()*sizeof(double),
+        bits ? n*words*sizeof(uint64_t) : 0,
+        subgraphs.size()*sizeof(int32_t), gtsp_sets.size()*sizeof(int32_t), strings.size()};
+
+    string temporary = filename + "." + to_string(getpid());
+    FILE *file = fopen(temporary.c_str(), "wb");
+    if (file == NULL) {
+        cerr << "error: could not write " << temporary << '\n';
+        return false;
+    }
+    uint64_t offset = sizeof(header);
+    fwrite(&header, sizeof(header), 1, file);
+    for (int i=0; i<H::SECTIONS; i++) {
+        static const char zeros[CACHE_LINE] = {0};
+        uint64_t padding = (CACHE_LINE - offset % CACHE_LINE) % CACHE_LINE;
+        fwrite(zeros, 1, padding, file);
+        offset += padding;
+        header.offset[i] = offset;
+        header.length[i] = length[i];
+        if (length[i] > 0)
+            fwrite(data[i], 1, length[i], file);
+        offset += length[i];
+    }
+    fseek(file, 0, SEEK_SET);
+    fwrite(&header, sizeof(header), 1, file);
+    bool ok = !ferror(file);
+    ok &= (fclose(file) == 0);
+    if (!ok || rename(temporary.c_str(), filename.c_str()) != 0) {
+        cerr << "error: could not write " << filename << '\n';
+        unlink(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+
+/************************************************************//**
+ * @brief	Map a compiled instance in place of parsing
+ * @version						v0.01b
+ * The clauses and the weight table are used from the mapping, which
+ * is private and writable so the graph may still be modified (copy
+ * on write). The mapping lives as long as the graph.
+ ****************************************************************/
+bool SATTSP::map_compiled (string filename)
+{
+    typedef Compiled_Header H;
+    int fd = open(filename.c_str(), O_RDONLY);
+    struct stat file_stat;
+    if (fd < 0 || fstat(fd, &file_stat) != 0 || file_stat.st_size < sizeof(H)) {
+        if (fd >= 0)
+            close(fd);
+        return false;
+    }
+    size_t length = file_stat.st_size;
+    void *mapping = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED)
+        return false;
+    compiled        = (char*) mapping;
+    compiled_length = length;
+
+    // validate before trusting any of it
+    const H &header = *(const H*) compiled;
+    if (memcmp(header.magic, COMPILED_MAGIC, 8) != 0 || header.version != COMPILED_VERSION || header.byte_order != 0x01020304)
+        return false;
+    for (int i=0; i<H::SECTIONS; i++) {
+        if (header.offset[i] % CACHE_LINE != 0 || header.offset[i] > length || header.length[i] > length - header.offset[i])
+            return false;
+    }
+    if (header.n < 0 || header.num_vars < 0 || header.num_clauses < 0)
+        return false;
+    uint64_t n = header.n;
+
+    // weights: a table laid out for its width, or (lazy) coordinates
+    if (header.kind < WEIGHT_EXPLICIT || header.kind > WEIGHT_CEIL_2D)
+        return false;
+    if (header.length[H::WEIGHTS] > 0 || header.kind == WEIGHT_EXPLICIT) {
+        if ((header.width != 16 && header.width != 32) || header.stride < header.n
+            || header.length[H::WEIGHTS] != n*header.stride*(header.width/8))
+            return false;
+    } else if (header.length[H::X] != n*sizeof(double) || header.length[H::Y] != n*sizeof(double)) {
+        return false;
+    }
+    if (!header.adjacency_full && header.length[H::ADJACENCY] != n*((n+63)/64)*sizeof(uint64_t))
+        return false;
+
+    // clauses: ends non-decreasing up to the literals, variables below num_vars
+    if (header.length[H::ENDS] != uint64_t(header.num_clauses)*sizeof(int32_t)
+        || header.length[H::LITS] % sizeof(Lit) != 0)
+        return false;
+    const int32_t *ends = (const int32_t*) (compiled + header.offset[H::ENDS]);
+    const int32_t *lits = (const int32_t*) (compiled + header.offset[H::LITS]);
+    int64_t num_lits = header.length[H::LITS]/sizeof(Lit);
+    for (int i=0, begin=0; i<header.num_clauses; begin=ends[i++]) {
+        if (ends[i] < begin || ends[i] > num_lits)
+            return false;
+    }
+    if ((header.num_clauses > 0 ? ends[header.num_clauses-1] : 0) != num_lits)
+        return false;
+    for (int64_t i=0; i<num_lits; i++) {
+        if (lits[i] < 0 || lits[i]/2 >= header.num_vars)
+            return false;
+    }
+
+    cnf.map(header.num_vars, header.num_clauses, (const Lit*) (compiled + header.offset[H::LITS]), ends);
+    graph->edge_weight.map(n, header.kind, header.width, header.stride,
+                           header.length[H::WEIGHTS] ? compiled + header.offset[H::WEIGHTS] : NULL,
+                           (const double*) (compiled + header.offset[H::X]),
+                           (const double*) (compiled + header.offset[H::Y]));
+    if (header.adjacency_full)
+        graph->adjacency.complete(n);
+    else
+        graph->adjacency.assign(n, (const uint64_t*) (compiled + header.offset[H::ADJACENCY]));
+    if (!unflatten((const int32_t*) (compiled + header.offset[H::SUBGRAPHS]), header.length[H::SUBGRAPHS], n, graph->subgraphs)
+        || !unflatten((const int32_t*) (compiled + header.offset[H::GTSP_SETS]), header.length[H::GTSP_SETS], n, graph->gtsp_sets))
+        return false;
+
+    vector<string> strings;
+    const char *text = compiled + header.offset[H::STRINGS];
+    for (const char *c = text; c < text + header.length[H::STRINGS]; c += strings.back().size()+1)
+        strings.push_back(string(c, strnlen(c, text + header.length[H::STRINGS] - c)));
+    strings.resize(4);
+    graph->name                 = strings[0];
+    graph->type                 = strings[1];
+    sat_filename                = strings[2];
+    tsp_filename                = strings[3];
+    graph->tsp_cost_budget      = header.tsp_cost_budget;
+    graph->subgraph_cost_budget = header.subgraph_cost_budget;
+    graph->filename             = filename;
+    graph->file_hash            = header.tsp_hash;
+    return true;
+}
+
+
+/************************************************************//**
+ * @brief	                    Publish every improved solution to filename
+ * @version						v0.01b
+ * The file is truncated. A path of the form /dev/fd/N writes to an
+ * already open descriptor.
+ ****************************************************************/
+bool SATTSP::set_incumbent_output (string filename)
+{
+  if (incumbent_fd >= 0)
+    close(incumbent_fd);
+  incumbent_fd = open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+  if (incumbent_fd < 0) {
+    cerr << "Error: could not open " << filename << " for incumbents\n";
+    return false;
+  }
+  return true;
+}
+
+
 /************************************************************//**
  * @brief	
  * @version						v0.01b
@@ -173,6 +593,33 @@ bool SATTSP::enable_mst_theory()
 }
 
 
+/************************************************************//**
+ * @brief	                    1-tree lower bound checked ahead of LKH
+ * @version						v0.01b
+ ****************************************************************/
+bool SATTSP::enable_held_karp_theory(int iterations)
+{
+  if (edge_theory)              return false;
+  if (!graph->symmetric())      return false;
+  if (!graph->tsp_monotonic())  return false;
+  bound_theory = new Held_Karp_Theory(graph, iterations);
+  theories.push_back(bound_theory);
+  vertex_theory = true;
+  return true;
+}
+
+
+/************************************************************//**
+ * @brief	                    Reuse one solver across all cost probes
+ * @version						v0.01b
+ ****************************************************************/
+bool SATTSP::enable_incremental()
+{
+  incremental = true;
+  return true;
+}
+
+
 /************************************************************//**
  * @brief	
  * @version						v0.01b
@@ -184,9 +631,7 @@ void SATTSP::reset_formula ()
     minisat_nLearnts += formula->num_learnts;
     delete formula;
     formula = new Solver();
-    gzFile cnf_file = gzopen(sat_filename.c_str(), "rb");
-    parse_DIMACS(cnf_file, *formula);
-    gzclose(cnf_file);
+    cnf.load(*formula);
 
     formula->callback_obj_pt          = this;
     formula->trail_push_callback      = &SATTSP::minisat_trail_push_cb_wrapper;
@@ -196,6 +641,21 @@ void SATTSP::reset_formula ()
     formula->random_seed              = rand();
     formula->rnd_init_act             = true;
     formula->random_var_freq          = 0.01; // in [0,1]
+    if (exchange != NULL) {
+        formula->export_clause_callback = &SATTSP::minisat_export_clause_cb_wrapper;
+        formula->import_clause_callback = &SATTSP::minisat_import_clause_cb_wrapper;
+    }
+    // diversify the portfolio, worker 0 keeps the defaults
+    if (worker_id > 0) {
+        formula->luby_restart         = (worker_id % 2 == 0);
+        formula->phase_saving         = worker_id % 3;
+        formula->rnd_pol              = (worker_id % 4 == 3);
+        formula->random_var_freq      = 0.01 * (1 + worker_id % 5);
+    }
+    budget_tsp_costs.clear();
+    budget_subgraph_costs.clear();
+    budget_lits.clear();
+    budget_lit                        = lit_Undef;
 
     if (edge_theory)
         graph->tsp2cnf(formula);
@@ -228,6 +688,41 @@ void SATTSP::reset_formula ()
 }
 
 
+/************************************************************//**
+ * @brief	                    Select the clauses that hold under the current budget
+ * @version						v0.01b
+ *
+ * Every cost conflict learnt in incremental mode carries the negated
+ * selector of the budget it was learnt under. A conflict that holds
+ * under a budget also holds under any tighter budget, so all selectors
+ * of budgets at least as large as the current one are assumed true and
+ * the remaining ones false.
+ ****************************************************************/
+void SATTSP::budget_assumptions (vec<Lit> &assumptions)
+{
+    int index(-1);
+    for (int i=0; i<budget_lits.size(); i++) {
+        if (budget_tsp_costs[i] == tsp_cost_budget && budget_subgraph_costs[i] == subgraph_cost_budget)
+            index = i;
+    }
+    if (index < 0) {
+        budget_tsp_costs.push_back(tsp_cost_budget);
+        budget_subgraph_costs.push_back(subgraph_cost_budget);
+        budget_lits.push_back(mkLit(formula->newVar(l_Undef, false)));
+        index = budget_lits.size()-1;
+    }
+    budget_lit = budget_lits[index];
+
+    assumptions.clear();
+    for (int i=0; i<budget_lits.size(); i++) {
+        if (tsp_cost_budget <= budget_tsp_costs[i] && subgraph_cost_budget <= budget_subgraph_costs[i])
+            assumptions.push(budget_lits[i]);
+        else
+            assumptions.push(~budget_lits[i]);
+    }
+}
+
+
 /************************************************************//**
  * @brief	
  * @version						v0.01b
@@ -237,7 +732,11 @@ void SATTSP::minisat_trail_push_cb_wrapper (void* _sattsp_ptr, const VMap<lbool>
     Lit push_lit = trail.last();
     int push_var = var(push_lit);
     propagate_list.clear();
+    if (sattsp_ptr->bound_theory != NULL) {
+        sattsp_ptr->bound_theory->minisat_trail_push_cb(assigns, trail, propagate_list);
+    }
     if (sattsp_ptr->tsp_theory != NULL) {
+        sattsp_ptr->tsp_theory->deferred = (sattsp_ptr->bound_theory != NULL && sattsp_ptr->bound_theory->conflicting());
         sattsp_ptr->tsp_theory->minisat_trail_push_cb(assigns, trail, propagate_list);
     }
 }
@@ -249,27 +748,33 @@ void SATTSP::minisat_trail_push_cb_wrapper (void* _sattsp_ptr, const VMap<lbool>
  ****************************************************************/
 bool SATTSP::minisat_check_conflict_cb_wrapper (void* _sattsp_ptr, const VMap<lbool> &assigns, const vec<Lit>& trail, vec<Lit>& conflict_list) {
     SATTSP* sattsp_ptr = (SATTSP*) _sattsp_ptr;
-    if (sattsp_ptr->tsp_theory != NULL) {
-        bool conflict = sattsp_ptr->tsp_theory->minisat_check_conflict_cb(assigns, trail, conflict_list);
-        #if defined(MINISAT_VERBOSE) && defined(__GXX_EXPERIMENTAL_CXX0X__)
-            if (conflict_list.size()) {
-                string s = "  conflict_list  = [";
-                for (int i=0; i<conflict_list.size(); i++) {
-                    Lit lit = conflict_list[i];
-                    int x = var(lit);
-                    if (!sign(lit))
-                        s += "x" + to_string(x) + ",";
-                    else
-                        s += "-x" + to_string(x) + ",";
-                }
-                s = s.substr(0, s.size()-1);
-                s += "] \n";
-                cout << s;
+    bool conflict = false;
+    if (sattsp_ptr->bound_theory != NULL)
+        conflict = sattsp_ptr->bound_theory->minisat_check_conflict_cb(assigns, trail, conflict_list);
+    if (!conflict && sattsp_ptr->tsp_theory != NULL)
+        conflict = sattsp_ptr->tsp_theory->minisat_check_conflict_cb(assigns, trail, conflict_list);
+    if (conflict)
+        sattsp_ptr->export_clause(conflict_list);
+    if (conflict && sattsp_ptr->budget_lit != lit_Undef)
+        conflict_list.push(~sattsp_ptr->budget_lit);
+    #if defined(MINISAT_VERBOSE) && defined(__GXX_EXPERIMENTAL_CXX0X__)
+        if (conflict_list.size()) {
+            string s = "  conflict_list  = [";
+            for (int i=0; i<conflict_list.size(); i++) {
+                Lit lit = conflict_list[i];
+                int x = var(lit);
+                if (!sign(lit))
+                    s += "x" + to_string(x) + ",";
+                else
+                    s += "-x" + to_string(x) + ",";
             }
-        #endif        
-        if (conflict != CRef_Undef) sattsp_ptr->new_clauses++;
-        return conflict;
-    }
+            s = s.substr(0, s.size()-1);
+            s += "] \n";
+            cout << s;
+        }
+    #endif        
+    if (conflict != CRef_Undef) sattsp_ptr->new_clauses++;
+    return conflict;
 }
 
 
@@ -279,6 +784,9 @@ bool SATTSP::minisat_check_conflict_cb_wrapper (void* _sattsp_ptr, const VMap<lb
  ****************************************************************/
 void SATTSP::minisat_trail_shrink_cb_wrapper (void* _sattsp_ptr, const VMap<lbool> &assigns, const vec<Lit>& trail, int amount) {
     SATTSP* sattsp_ptr = (SATTSP*) _sattsp_ptr;
+    if (sattsp_ptr->bound_theory != NULL) {
+        sattsp_ptr->bound_theory->minisat_trail_shrink_cb(assigns, trail, amount);
+    }
     if (sattsp_ptr->tsp_theory != NULL) {
         sattsp_ptr->tsp_theory->minisat_trail_shrink_cb(assigns, trail, amount);
     }
@@ -292,6 +800,9 @@ void SATTSP::minisat_trail_shrink_cb_wrapper (void* _sattsp_ptr, const VMap<lboo
 bool SATTSP::minisat_within_budget_cb_wrapper (void* _sattsp_ptr) {
     SATTSP* sattsp_ptr = (SATTSP*) _sattsp_ptr;
 
+    if (sattsp_ptr->interrupted)
+        return false;
+
     // time budget
     timeval toc;
     gettimeofday (&toc, NULL);
@@ -304,6 +815,55 @@ bool SATTSP::minisat_within_budget_cb_wrapper (void* _sattsp_ptr) {
 
 
 
+/************************************************************//**
+ * @brief	                    Share short learnt clauses with the portfolio
+ * @version						v0.01b
+ ****************************************************************/
+void SATTSP::minisat_export_clause_cb_wrapper (void* _sattsp_ptr, const vec<Lit> &clause) {
+    SATTSP* sattsp_ptr = (SATTSP*) _sattsp_ptr;
+    if (clause.size() <= sattsp_ptr->share_size)
+        sattsp_ptr->export_clause(clause);
+}
+
+
+/************************************************************//**
+ * @brief	                    Next clause shared by the rest of the portfolio
+ * @version						v0.01b
+ * In incremental mode the clause is tagged with the budget selector,
+ * it was learnt under the same budget by the other worker.
+ ****************************************************************/
+bool SATTSP::minisat_import_clause_cb_wrapper (void* _sattsp_ptr, vec<Lit> &clause) {
+    SATTSP* sattsp_ptr = (SATTSP*) _sattsp_ptr;
+    if (!sattsp_ptr->exchange->import_clause(sattsp_ptr->worker_id, sattsp_ptr->exchange_cursor, clause))
+        return false;
+    if (sattsp_ptr->budget_lit != lit_Undef)
+        clause.push(~sattsp_ptr->budget_lit);
+    return true;
+}
+
+
+/************************************************************//**
+ * @brief	                    Hand a clause to the portfolio
+ * @version						v0.01b
+ * The budget selector of this worker is dropped, clauses on any
+ * other variable the other workers do not share are not exported.
+ ****************************************************************/
+void SATTSP::export_clause (const vec<Lit> &clause) {
+    if (exchange == NULL)
+        return;
+    vec<Lit> shared;
+    for (int i=0; i<clause.size(); i++) {
+        if (budget_lit != lit_Undef && clause[i] == ~budget_lit)
+            continue;
+        if (var(clause[i]) >= cnf.nVars())
+            return;
+        shared.push(clause[i]);
+    }
+    if (shared.size() > 0)
+        exchange->export_clause(worker_id, shared);
+}
+
+
 /************************************************************//**
  * @brief	
  * @version						v0.01b
@@ -311,6 +871,10 @@ bool SATTSP::minisat_within_budget_cb_wrapper (void* _sattsp_ptr) {
  ****************************************************************/
 bool SATTSP::solve_optimal (int verbose_level)
 {
+    gettimeofday (&search_start, NULL);
+    if (probes > 1 && !edge_theory)
+        return solve_probes(verbose_level);
+
     int           test_min(0), test_cost(0), test_max(soln_cost);
     int           bin_div(bdiv_parameter);    
     if (search_method == ADAPTIVE_BINARY) {
@@ -326,7 +890,8 @@ bool SATTSP::solve_optimal (int verbose_level)
     #endif   
 
     // search
-    reset_formula();    // hack!
+    if (!incremental)
+        reset_formula();    // hack!
     while (true) {
         if (verbose_level >= 100)
             printf("\ntest_min=%d, test_cost=%d, test_max=%d\n", test_min, test_cost, test_max);
@@ -343,9 +908,12 @@ bool SATTSP::solve_optimal (int verbose_level)
         if (solved) {
             get_solution();
             // TODO: allow for solutions of size 3 and less
-            assert (verify_soln());
+            bool verified = verify_soln();
+            assert (verified);
             if (soln_tour.size() == 0)
                 cerr << "Error: zero sized tour\n";
+            if (verified)
+                publish_incumbent();
             test_max = soln_cost - 1;
             if (verbose_level == 1)
                 cout << "+";
@@ -371,7 +939,8 @@ bool SATTSP::solve_optimal (int verbose_level)
                 cout << ".";
             }
             // reset formula
-            reset_formula();
+            if (!incremental)
+                reset_formula();
         }
         cout.flush();
         if (search_method == BINARY || search_method == ADAPTIVE_BINARY) {
@@ -397,16 +966,283 @@ bool SATTSP::solve_optimal (int verbose_level)
 }
 
 
+/************************************************************//**
+ * @brief	                    solve_optimal() with several cost probes at once
+ * @version						v0.01b
+ *
+ * Each probe thread takes the widest gap between the window bounds
+ * and the costs being probed, and probes a cost in it by the search
+ * method. A solution of cost c moves test_max below c and stops the
+ * probes above it, a refutation of cost c moves test_min above c and
+ * stops the probes below it.
+ ****************************************************************/
+bool SATTSP::solve_probes (int verbose_level)
+{
+    int             test_min(0), test_max(soln_cost);
+    int             bin_div(search_method == ADAPTIVE_BINARY ? 2 : bdiv_parameter);
+    vector<SATTSP*> probe(probes);
+    vector<int>     probe_cost(probes);
+    vector<bool>    running(probes, false);
+    mutex           m;
+    condition_variable changed;
+    solving         = true;
+
+    // settle the lazily detected graph properties before sharing the graph
+    graph->symmetric();
+    graph->tsp_monotonic();
+
+    timeval tic;
+    gettimeofday (&tic, NULL);
+    for (int i=0; i<probes; i++)
+        probe[i] = new SATTSP(this);
+
+    vector<thread> threads;
+    for (int i=0; i<probes; i++) {
+        threads.push_back(thread([&, i]() {
+            unique_lock<mutex> lock(m);
+            while (true) {
+                // widest gap between the window bounds and the running probes
+                int test_cost(-1);
+                while (test_min <= test_max) {
+                    vector<int> bounds;
+                    bounds.push_back(test_min-1);
+                    bounds.push_back(test_max+1);
+                    for (int j=0; j<probes; j++) {
+                        if (running[j])
+                            bounds.push_back(probe_cost[j]);
+                    }
+                    sort(bounds.begin(), bounds.end());
+                    int gap(0);
+                    for (int j=1; j<bounds.size(); j++) {
+                        if (bounds[j]-bounds[j-1] > bounds[gap+1]-bounds[gap])
+                            gap = j-1;
+                    }
+                    int low(bounds[gap]), high(bounds[gap+1]);
+                    if (high - low >= 2) {
+                        if (search_method == LINEAR)
+                            test_cost = high-1;
+                        else
+                            test_cost = max(low+1, high-1 - (high-low-2)/bin_div);
+                        break;
+                    }
+                    changed.wait(lock);
+                }
+                if (test_min > test_max)
+                    return;
+                if (verbose_level >= 100)
+                    printf("\ntest_min=%d, test_cost=%d, test_max=%d\n", test_min, test_cost, test_max);
+                running[i]          = true;
+                probe_cost[i]       = test_cost;
+                probe[i]->interrupted = false;
+                lock.unlock();
+
+                bool solved(false);
+                if (graph->type == "MIN_MAX_TSP") {
+                    solved = probe[i]->solve(tsp_cost_budget, test_cost);
+                } else {
+                    solved = probe[i]->solve(test_cost, subgraph_cost_budget);
+                }
+                if (solved)
+                    probe[i]->get_solution();
+
+                lock.lock();
+                running[i] = false;
+                if (solved) {
+                    // verify_soln() solves the shared original_formula
+                    bool verified = probe[i]->verify_soln();
+                    assert (verified);
+                    if (verified && (probe[i]->soln_cost < soln_cost || soln_tour.size() == 0)) {
+                        soln_cost     = probe[i]->soln_cost;
+                        soln_tour     = probe[i]->soln_tour;
+                        soln_assigns  = probe[i]->soln_assigns;
+                        publish_incumbent();
+                    }
+                    test_max = min(test_max, probe[i]->soln_cost - 1);
+                    if (verbose_level == 1)
+                        cout << "+";
+                    if (verbose_level >= 2) {
+                        printf("\nFound New Soln:\n");
+                        printf("  soln.cost(): %d\n", soln_cost);
+                        printf("  soln.len():  %d\n", int(soln_tour.size()));
+                    }
+                } else if (!probe[i]->interrupted) {
+                    test_min = max(test_min, test_cost + 1);
+                    if (verbose_level == 1)
+                        cout << "o";
+                    if (verbose_level >= 2)
+                        cout << ".";
+                }
+                cout.flush();
+                for (int j=0; j<probes; j++) {
+                    if (running[j] && (probe_cost[j] < test_min || probe_cost[j] > test_max))
+                        probe[j]->interrupted = true;
+                }
+                changed.notify_all();
+            }
+        }));
+    }
+    for (int i=0; i<probes; i++)
+        threads[i].join();
+    printf("\n");
+
+    timeval toc;
+    gettimeofday (&toc, NULL);
+    vector<Stats> deltas;
+    for (int i=0; i<probes; i++) {
+        deltas.push_back(probe[i]->stats());
+        if (probe[i]->cb_minisat_error >= 0)
+            cb_minisat_error = probe[i]->cb_minisat_error;
+        delete probe[i];
+    }
+    merge_stats(deltas, toc.tv_sec - tic.tv_sec + (double) (toc.tv_usec - tic.tv_usec) / 1000000);
+
+    solving = false;
+    return soln_tour.size() > 0;
+}
+
+
+/************************************************************//**
+ * @brief	                    Race the portfolio on one cost budget
+ * @version						v0.01b
+ *
+ * Every worker solves the same budget with its own formula, theories
+ * and search parameters, sharing clauses through shared_clauses. The
+ * first to finish decides, and its model becomes the model of this
+ * solver. The workers are kept, so incremental mode keeps their
+ * learnt clauses across budgets.
+ ****************************************************************/
+bool SATTSP::solve_portfolio (int _tsp_cost_budget, int _subgraph_cost_budget)
+{
+    if (workers.size() == 0) {
+        // settle the lazily detected graph properties before sharing the graph
+        graph->symmetric();
+        graph->tsp_monotonic();
+        for (int i=0; i<portfolio; i++) {
+            SATTSP *worker      = new SATTSP(this);
+            worker->exchange    = &shared_clauses;
+            worker->worker_id   = i;
+            worker->share_size  = share_size;
+            workers.push_back(worker);
+        }
+    }
+    tsp_cost_budget = min(_tsp_cost_budget, graph->tsp_cost_budget);
+    subgraph_cost_budget = min(_subgraph_cost_budget, graph->subgraph_cost_budget);
+
+    // clauses learnt under another budget may not hold under this one
+    shared_clauses.clear();
+    vector<Stats> before;
+    for (int i=0; i<workers.size(); i++) {
+        before.push_back(workers[i]->stats());
+        workers[i]->exchange_cursor = 0;
+        workers[i]->interrupted     = false;
+    }
+
+    timeval tic;
+    gettimeofday (&tic, NULL);
+    mutex           m;
+    int             winner(-1);
+    vector<char>    solved(workers.size(), false);
+    vector<thread>  threads;
+    for (int i=0; i<workers.size(); i++) {
+        threads.push_back(thread([&, i]() {
+            solved[i] = workers[i]->solve(_tsp_cost_budget, _subgraph_cost_budget);
+            lock_guard<mutex> lock(m);
+            if (winner < 0) {
+                winner = i;
+                for (int j=0; j<workers.size(); j++) {
+                    if (j != i)
+                        workers[j]->interrupted = true;
+                }
+            }
+        }));
+    }
+    for (int i=0; i<threads.size(); i++)
+        threads[i].join();
+    timeval toc;
+    gettimeofday (&toc, NULL);
+
+    vector<Stats> deltas;
+    for (int i=0; i<workers.size(); i++) {
+        Stats after = workers[i]->stats();
+        after.solver_time       -= before[i].solver_time;
+        after.theory_time       -= before[i].theory_time;
+        after.bound_time        -= before[i].bound_time;
+        after.reduction_time    -= before[i].reduction_time;
+        after.decisions         -= before[i].decisions;
+        after.learnts           -= before[i].learnts;
+        after.new_clauses       -= before[i].new_clauses;
+        deltas.push_back(after);
+        if (workers[i]->cb_minisat_error >= 0)
+            cb_minisat_error = workers[i]->cb_minisat_error;
+    }
+    merge_stats(deltas, toc.tv_sec - tic.tv_sec + (double) (toc.tv_usec - tic.tv_usec) / 1000000);
+
+    if (!solved[winner])
+        return false;
+    workers[winner]->formula->model.copyTo(formula->model);
+    tsp_theory->soln_tour = workers[winner]->tsp_theory->soln_tour;
+    return true;
+}
+
+
+/************************************************************//**
+ * @brief	                    Counters of this solver so far
+ * @version						v0.01b
+ ****************************************************************/
+SATTSP::Stats SATTSP::stats ()
+{
+    Stats result;
+    result.solver_time      = solver_time;
+    result.theory_time      = theory_time;
+    result.bound_time       = bound_time;
+    result.reduction_time   = reduction_time;
+    result.decisions        = minisat_nDecisions + formula->decisions;
+    result.learnts          = minisat_nLearnts + formula->num_learnts;
+    result.new_clauses      = new_clauses;
+    return result;
+}
+
+
+/************************************************************//**
+ * @brief	                    Add the counters of solvers run in parallel
+ * @version						v0.01b
+ * Their times are summed, then scaled to the wall clock time.
+ ****************************************************************/
+void SATTSP::merge_stats (const vector<Stats> &deltas, double wall_time)
+{
+    double total_time(0), total_theory_time(0), total_bound_time(0);
+    for (int i=0; i<deltas.size(); i++) {
+        total_time          += deltas[i].solver_time;
+        total_theory_time   += deltas[i].theory_time;
+        total_bound_time    += deltas[i].bound_time;
+        reduction_time      += deltas[i].reduction_time;
+        minisat_nDecisions  += deltas[i].decisions;
+        minisat_nLearnts    += deltas[i].learnts;
+        new_clauses         += deltas[i].new_clauses;
+    }
+    solver_time += wall_time;
+    if (total_time > 0) {
+        theory_time += total_theory_time * wall_time / total_time;
+        bound_time  += total_bound_time * wall_time / total_time;
+    }
+}
+
+
 /************************************************************//**
  * @brief	
  * @version						v0.01b
  ****************************************************************/
 bool SATTSP::solve (int _tsp_cost_budget, int _subgraph_cost_budget)
 {
+    if (portfolio > 1 && !edge_theory)
+        return solve_portfolio(_tsp_cost_budget, _subgraph_cost_budget);
+
     // time budget: wall clock required since external calls are made to LKH
     timeval tic;
     gettimeofday (&tic, NULL);
     tsp_theory->theory_time = 0;
+    if (bound_theory != NULL)
+        bound_theory->theory_time = 0;
     if (usat_time_budget > 0) {
         max_wall_time.tv_sec = tic.tv_sec + usat_time_budget;
     } else {
@@ -426,8 +1262,16 @@ bool SATTSP::solve (int _tsp_cost_budget, int _subgraph_cost_budget)
     subgraph_cost_budget = min(_subgraph_cost_budget, graph->subgraph_cost_budget);
     tsp_theory->tsp_cost_budget = tsp_cost_budget;
     tsp_theory->subgraph_cost_budget = subgraph_cost_budget;
+    if (bound_theory != NULL) {
+        bound_theory->tsp_cost_budget = tsp_cost_budget;
+        bound_theory->subgraph_cost_budget = subgraph_cost_budget;
+    }
     bool result(false);
-    reset_formula();    // hack!
+    graph->forget_lkh_failures();   // LKH failures of earlier solves are not proofs
+    if (!incremental || budget_lits.size() == 0)
+        reset_formula();    // hack!
+    if (incremental)
+        budget_assumptions(assumptions);
     if (conflict_budget >=0)    formula->setConfBudget    (conflict_budget);
     if (propagation_budget >=0) formula->setPropBudget    (propagation_budget);
 
@@ -454,6 +1298,8 @@ bool SATTSP::solve (int _tsp_cost_budget, int _subgraph_cost_budget)
                         }
                     }
                     if (mst_theory) {
+                        delete mst;
+                        mst = new MST(graph, vids);
                         if (2*mst->cost() <= tsp_cost_budget) {
                             #ifdef DEBUG
                             printf("\n");
@@ -475,6 +1321,8 @@ bool SATTSP::solve (int _tsp_cost_budget, int _subgraph_cost_budget)
                             for (int i=0; i<vids.size(); i++) {
                                 negate.push(mkLit(graph->vid2var(vids[i]), true));
                             }
+                            if (incremental)
+                                negate.push(~budget_lit);
                             formula->addClause(negate);
                             result = false;
 
@@ -490,14 +1338,16 @@ bool SATTSP::solve (int _tsp_cost_budget, int _subgraph_cost_budget)
                     }
 
                     if (lkh_theory) {
-                        graph->solve(vids, tsp_cost_budget, subgraph_cost_budget, solution, cost);
-                        if (cost <= tsp_cost_budget) {
+                        // with cb_interval > 1 the theory may not have seen the full model
+                        if (graph->solve(vids, tsp_cost_budget, subgraph_cost_budget, solution, cost, &tsp_theory->soln_tour)) {
                             break;
                         } else {
                             vec<Lit> negate;
                             for (int i=0; i<vids.size(); i++) {
                                 negate.push(mkLit(graph->vid2var(vids[i]), true));
                             }
+                            if (incremental)
+                                negate.push(~budget_lit);
                             formula->addClause(negate);
                             result = false;
 
@@ -523,6 +1373,8 @@ bool SATTSP::solve (int _tsp_cost_budget, int _subgraph_cost_budget)
     solver_time += toc.tv_sec - tic.tv_sec;
     solver_time += (double) (toc.tv_usec - tic.tv_usec) / 1000000;
     theory_time += tsp_theory->theory_time;
+    if (bound_theory != NULL)
+        bound_time += bound_theory->theory_time;
     if (formula->callback_error >= 0) {
         cb_minisat_error = formula->callback_error;
         formula->callback_error = -1;
@@ -614,15 +1466,13 @@ bool SATTSP::verify_soln (const int &cost, const vector<int> &tour, const vector
         }
     }
 
-    int cost_calc(0);
-    for (int i=1; i < tour.size(); i++) {
-        int vid00 = tour[i-1];
-        int vid01 = tour[i];
-        cost_calc += graph->edge_weight[vid00][vid01];
+    int cost_calc, tsp_cost, max_subgraph_cost;
+    graph->get_tour_cost(tour, tsp_cost, max_subgraph_cost);
+    if (graph->type == "MIN_MAX_TSP") {
+        cost_calc = max_subgraph_cost;
+    } else {
+        cost_calc = tsp_cost;
     }
-    int vid00 = tour.back();
-    int vid01 = tour[0];
-    cost_calc += graph->edge_weight[vid00][vid01];
     if (cost_calc != cost) {
         if (verbose_level > 0) {
             printf("SATTSP::verify_soln()\n");
@@ -718,7 +1568,7 @@ void SATTSP::get_solution ()
         vid_set.push_back(graph->var2vid(var));
       }
     }
-    graph->solve(vid_set, tsp_cost_budget, subgraph_cost_budget, soln_tour, soln_cost);
+    graph->solve(vid_set, tsp_cost_budget, subgraph_cost_budget, soln_tour, soln_cost, &tsp_theory->soln_tour);
     #ifdef DEBUG
         cout << "SATTSP::get_solution():\n";
         cout << "  cost = " << soln_cost << '\n';
@@ -768,6 +1618,7 @@ string SATTSP::output_conf ()
     output << boost::format("  Edge Theory:         %s\n")     % (edge_theory?"Enabled":"Disabled");
     output << boost::format("  LKH Theory:          %s\n")     % (lkh_theory?"Enabled":"Disabled");
     output << boost::format("  MST Theory:          %s\n")     % (mst_theory?"Enabled":"Disabled");
+    output << boost::format("  Held-Karp Theory:    %s\n")     % (bound_theory?"Enabled":"Disabled");
     switch (search_method) {
         case LINEAR:
             output << boost::format("  Search:              Linear\n");
@@ -781,6 +1632,11 @@ string SATTSP::output_conf ()
     }
     if (search_method == BINARY || search_method == ADAPTIVE_BINARY)
         output << boost::format("  B-Search Divider:    %d\n")     % (bdiv_parameter);
+    output << boost::format("  Incremental:         %s\n")     % (incremental?"Enabled":"Disabled");
+    output << boost::format("  Threads:             %d\n")     % graph->threads();
+    output << boost::format("  LKH Seeds:           %d\n")     % graph->lkh_seeds();
+    output << boost::format("  Probes:              %d\n")     % probes;
+    output << boost::format("  Portfolio:           %d\n")     % portfolio;
     output << boost::format("  Library:             sattsp.cpp\n");
     output << boost::format("  Version:             v%0.2f\n") % (LIB_VER);
     output << boost::format("  Conflict Budget:     %ld\n")    % (conflict_budget);
@@ -800,7 +1656,7 @@ string SATTSP::output_conf ()
  ****************************************************************/
 string SATTSP::output_stats ()
 {
-    double minisat_time = solver_time - theory_time;
+    double minisat_time = solver_time - theory_time - bound_time;
     minisat_nDecisions += formula->decisions;
     minisat_nLearnts += formula->num_learnts;
     vector<string> sat_tokens, tsp_tokens;
@@ -820,6 +1676,10 @@ string SATTSP::output_stats ()
     output << boost::format("    nDecisions:        %d\n") % minisat_nDecisions;
     output << boost::format("    nLearnts:          %d\n") % minisat_nLearnts;
     output << boost::format("  LKH Time:            %f\n") % theory_time;
+    output << boost::format("    Cache Hits:        %d\n") % graph->cache.hits;
+    output << boost::format("    Cache Misses:      %d\n") % graph->cache.misses;
+    if (bound_theory != NULL)
+        output << boost::format("  Held-Karp Time:      %f\n") % bound_time;
     output << boost::format("  Solver Time:         %f\n") % solver_time;
     if (solver_time_budget > 0 && solver_time > solver_time_budget)
         output << boost::format("  Timed Out:           True\n");
@@ -829,6 +1689,44 @@ string SATTSP::output_stats ()
 }
 
 
+/************************************************************//**
+ * @brief	                    Write the solution as one line of JSON
+ * @version						v0.01b
+ * The record goes out in a single append, so a reader never sees
+ * part of it unless the write is cut short, and the last complete
+ * line is always the best solution so far.
+ ****************************************************************/
+void SATTSP::publish_incumbent ()
+{
+    if (incumbent_fd < 0 || soln_tour.size() == 0)
+        return;
+    timeval now;
+    gettimeofday (&now, NULL);
+    int tsp_cost(0), max_subgraph_cost(0);
+    graph->get_tour_cost(soln_tour, tsp_cost, max_subgraph_cost);
+
+    stringstream record;
+    record << boost::format("{\"time\": %d.%06d, ") % now.tv_sec % now.tv_usec;
+    record << boost::format("\"elapsed\": %f, ") % (now.tv_sec - search_start.tv_sec + (double) (now.tv_usec - search_start.tv_usec) / 1000000);
+    record << boost::format("\"cost\": %d, \"tsp_cost\": %d, \"max_subgraph_cost\": %d, ") % soln_cost % tsp_cost % max_subgraph_cost;
+    record << "\"tour\": [";
+    for (int i=0; i<soln_tour.size(); i++)
+        record << (i > 0 ? "," : "") << soln_tour[i];
+    record << "], \"vars\": [";
+    for (int i=0; i<soln_assigns.size(); i++)
+        record << (i > 0 ? "," : "") << (soln_assigns[i] ? 1 : 0);
+    record << "]}\n";
+
+    string line = record.str();
+    for (size_t done=0; done < line.size(); ) {
+        ssize_t n = write(incumbent_fd, line.c_str()+done, line.size()-done);
+        if (n < 0)
+            break;
+        done += n;
+    }
+}
+
+
 /************************************************************//**
  * @brief	
  * @version						v0.01b
@@ -937,7 +1835,7 @@ void SATTSP::print_smt2 (int tsp_cost_budget)
       for (int vid01=0; vid01<graph->size(); vid01++) {
         int eid = graph->edge2eid(vid00, vid01);
         int     var = graph->eid2var(eid);
-        int cost = graph->edge_weight[vid00][vid01];
+        int cost = graph->edge_weight(vid00,vid01);
         cout << "(define-fun c" << var << " () Int (ite x" << var << ' ' << cost << " 0))\n";
       }
     }
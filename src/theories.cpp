@@ -195,6 +195,15 @@ bool Edge_TSP_Theory::minisat_check_conflict_cb (const VMap<lbool> &assigns, con
  ****************************************************************/
 Metric_TSP_Theory::Metric_TSP_Theory (TSP *graph, int verbose_level)
     : graph(graph)
+    , conflict(false)
+    , conflict_checked(true)
+    , interval(1)
+    , check_latency(0)
+    , conflict_rate(0)
+    , explain_solves(3)
+    , max_cores(1000)
+    , latency_target(0.001)
+    , max_interval(64)
 {}
 
 /************************************************************//**
@@ -203,9 +212,177 @@ Metric_TSP_Theory::Metric_TSP_Theory (TSP *graph, int verbose_level)
  ****************************************************************/
 void Metric_TSP_Theory::reset() {
     soln_vids.clear();
+    tour_sizes.clear();
+    tour_stack.clear();
+    core_vids.clear();
     conflict = false;
 }
 
+/************************************************************//**
+ * @brief	Look for a proven core inside vids
+ * @version						v0.01b
+ * A core proven under some budgets stays infeasible under any
+ * budgets that are not larger, so cores outlive reset().
+ ****************************************************************/
+bool Metric_TSP_Theory::find_core (const vector<int> &vids, vector<int> &core) {
+    uint64_t signature = 0;
+    for (int i=0; i<vids.size(); i++)
+        signature |= uint64_t(1) << (vids[i] % 64);
+    vector<int> sorted;
+    for (list<Core>::iterator it = cores.begin(); it != cores.end(); it++) {
+        if ((it->signature & ~signature) || it->vids.size() > vids.size())
+            continue;
+        if (tsp_cost_budget > it->tsp_cost_budget || subgraph_cost_budget > it->subgraph_cost_budget)
+            continue;
+        if (sorted.size() == 0) {
+            sorted = vids;
+            sort(sorted.begin(), sorted.end());
+        }
+        if (includes(sorted.begin(), sorted.end(), it->vids.begin(), it->vids.end())) {
+            core = it->vids;
+            cores.splice(cores.begin(), cores, it);
+            return true;
+        }
+    }
+    return false;
+}
+
+/************************************************************//**
+ * @brief	
+ * @version						v0.01b
+ ****************************************************************/
+void Metric_TSP_Theory::add_core (const vector<int> &vids) {
+    if (max_cores <= 0)
+        return;
+    Core core;
+    core.vids = vids;
+    sort(core.vids.begin(), core.vids.end());
+    core.signature = 0;
+    for (int i=0; i<vids.size(); i++)
+        core.signature |= uint64_t(1) << (vids[i] % 64);
+    core.tsp_cost_budget = tsp_cost_budget;
+    core.subgraph_cost_budget = subgraph_cost_budget;
+    cores.push_front(core);
+    if (cores.size() > max_cores)
+        cores.pop_back();
+}
+
+/************************************************************//**
+ * @brief	Is there no tour through vids within the budgets?
+ * @version						v0.01b
+ * Cheapest test first: proven cores, then the 1-tree bound of each
+ * subgraph (symmetric instances), then LKH while solves remain.
+ ****************************************************************/
+bool Metric_TSP_Theory::refuted (const vector<int> &vids, int &solves) {
+    vector<int> core;
+    if (find_core(vids, core))
+        return true;
+
+    if (graph->symmetric()) {
+        vector<vector<int>> sub_vids;
+        graph->split_vids(vids, sub_vids);
+        int total(0), worst(0);
+        for (int i=0; i<sub_vids.size(); i++) {
+            int bound = graph->one_tree_bound(sub_vids[i]);
+            total += bound;
+            worst  = max(worst, bound);
+        }
+        if (total > tsp_cost_budget || worst > subgraph_cost_budget)
+            return true;
+    }
+
+    if (solves <= 0)
+        return false;
+    solves--;
+    vector<int> tour;
+    int cost;
+    return !graph->solve(vids, tsp_cost_budget, subgraph_cost_budget, tour, cost);
+}
+
+/************************************************************//**
+ * @brief	Deletion based shrinking of an infeasible vertex set
+ * @version						v0.01b
+ * Drops each vertex in turn and keeps the smaller set whenever it is
+ * still refuted. The result is minimal as far as the tests can tell.
+ ****************************************************************/
+void Metric_TSP_Theory::minimize (vector<int> &vids) {
+    int solves = explain_solves;
+    for (int i=vids.size()-1; i>=0 && vids.size() > 1; i--) {
+        vector<int> candidate(vids);
+        candidate.erase(candidate.begin()+i);
+        if (refuted(candidate, solves))
+            vids = candidate;
+    }
+}
+
+/************************************************************//**
+ * @brief	True once enough vertices are pushed since the last check
+ * @version						v0.01b
+ * A fixed cb_interval checks every cb_interval vertices, cb_interval 0
+ * batches the adaptive interval, counted from the last feasible tour.
+ ****************************************************************/
+bool Metric_TSP_Theory::due () {
+    if (cb_interval > 0)
+        return soln_vids.size() % cb_interval == 0;
+    int base_size = tour_sizes.size() > 0 ? tour_sizes.back() : 0;
+    return soln_vids.size() - base_size >= interval;
+}
+
+/************************************************************//**
+ * @brief	Check the feasibility of soln_vids and tune the interval
+ * @version						v0.01b
+ ****************************************************************/
+void Metric_TSP_Theory::check () {
+    double not_lkh_time;
+    clock_t tic00 = clock();
+
+    timeval tic,toc;
+    gettimeofday (&tic, NULL);
+    // extend the last feasible tour, fall back to LKH
+    int base_size = tour_sizes.size() > 0 ? tour_sizes.back() : 0;
+    vector<int> base_tour;
+    if (tour_stack.size() > 0)
+        base_tour = tour_stack.back();
+    vector<int> new_vids(soln_vids.begin()+base_size, soln_vids.end());
+    conflict = !graph->extend(base_tour, new_vids, tsp_cost_budget, subgraph_cost_budget, soln_tour);
+    core_vids.clear();
+    if (conflict && find_core(soln_vids, core_vids)) {
+        // proven before, no need for LKH
+    } else if (conflict) {
+        // warm start LKH from the extended tour
+        int soln_cost;
+        vector<int> warm_tour;
+        warm_tour.swap(soln_tour);
+        conflict = !graph->solve(soln_vids, tsp_cost_budget, subgraph_cost_budget, soln_tour, soln_cost, &warm_tour);
+    }
+    if (!conflict) {
+        tour_sizes.push_back(soln_vids.size());
+        tour_stack.push_back(soln_tour);
+    }
+    conflict_checked = false;
+    gettimeofday (&toc, NULL);
+    theory_time += toc.tv_sec - tic.tv_sec;
+    theory_time += (double) (toc.tv_usec - tic.tv_usec) / 1000000;
+
+    clock_t toc00 = clock();
+    not_lkh_time += (double) (toc00-tic00) / CLOCKS_PER_SEC;
+    theory_time -= not_lkh_time;
+    if (cb_interval > 0)
+        return;
+
+    // productive checks run more often, costly feasible ones less
+    double latency = toc.tv_sec - tic.tv_sec + (double) (toc.tv_usec - tic.tv_usec) / 1000000;
+    if (!conflict)
+        check_latency = 0.9*check_latency + 0.1*latency;
+    conflict_rate = 0.9*conflict_rate + 0.1*(conflict ? 1 : 0);
+    if (conflict)
+        interval = max(1, interval/2);
+    else if (check_latency > latency_target && conflict_rate < 0.5)
+        interval = min(interval+1, max_interval);
+    else if (interval > 1)
+        interval--;
+}
+
 /************************************************************//**
  * @brief	
  * @version						v0.01b
@@ -221,25 +398,9 @@ void Metric_TSP_Theory::reset() {
             printf("Minisat::trail.push_vid(%d)\n", push_vid);
         #endif
 
-        // solve LKH
-        if (soln_vids.size() % cb_interval == 0) {
-            double not_lkh_time;
-            clock_t tic00 = clock();
-
-            timeval tic,toc;
-            gettimeofday (&tic, NULL);
-            int soln_cost;
-            soln_tour.clear();
-            conflict = !graph->solve(soln_vids, tsp_cost_budget, subgraph_cost_budget, soln_tour, soln_cost);
-            conflict_checked = false;
-            gettimeofday (&toc, NULL);
-            theory_time += toc.tv_sec - tic.tv_sec;
-            theory_time += (double) (toc.tv_usec - tic.tv_usec) / 1000000;
-
-            clock_t toc00 = clock();
-            not_lkh_time += (double) (toc00-tic00) / CLOCKS_PER_SEC;
-            theory_time -= not_lkh_time;
-        }
+        // solve LKH, unless a bound already refutes the trail
+        if (!deferred && due())
+            check();
     }
 }
 
@@ -257,6 +418,10 @@ void Metric_TSP_Theory::minisat_trail_shrink_cb (const VMap<lbool> &assigns, con
             conflict = false;
         }
     }
+    while (tour_sizes.size() > 0 && tour_sizes.back() > soln_vids.size()) {
+        tour_sizes.pop_back();
+        tour_stack.pop_back();
+    }
     #ifdef MINISAT_VERBOSE
         printf("Minisat::trail.shrink(%d)\n", amount);
         if (soln_vids.size() > 0)
@@ -271,22 +436,39 @@ void Metric_TSP_Theory::minisat_trail_shrink_cb (const VMap<lbool> &assigns, con
  * @version						v0.01b
  ****************************************************************/
 bool Metric_TSP_Theory::minisat_check_conflict_cb (const VMap<lbool> &assigns, const vec<Lit> &trail, vec<Lit> &conflict_list) {
+    // a full assignment is always checked, whatever the interval skipped
+    int base_size = tour_sizes.size() > 0 ? tour_sizes.back() : 0;
+    if (!conflict && !deferred && base_size < soln_vids.size() && trail.size() == assigns.end() - assigns.begin())
+        check();
     if (conflict_checked)
     return false;
     conflict_checked = true;
     conflict_list.clear();
 
     if (conflict) {
-        vector<int> negate_vids;
-        vector<vector<int>> sub_tours(graph->subgraphs.size());
-        graph->split_vids(soln_tour, sub_tours);
-        for (int i=0; i<graph->subgraphs.size(); i++){
-            if (!graph->feasible(sub_tours[i], tsp_cost_budget, subgraph_cost_budget)) {
-                negate_vids = sub_tours[i];
-            }
-        }
+        vector<int> negate_vids(core_vids);
         if (negate_vids.size() == 0) {
-            negate_vids = soln_vids;
+            vector<vector<int>> sub_tours(graph->subgraphs.size());
+            graph->split_vids(soln_tour, sub_tours);
+            for (int i=0; i<graph->subgraphs.size(); i++){
+                if (!graph->feasible(sub_tours[i], tsp_cost_budget, subgraph_cost_budget)) {
+                    negate_vids = sub_tours[i];
+                }
+            }
+            if (negate_vids.size() == 0) {
+                negate_vids = soln_vids;
+            }
+
+            // shrink the explanation and remember it
+            if (explain_solves >= 0) {
+                timeval tic, toc;
+                gettimeofday (&tic, NULL);
+                minimize(negate_vids);
+                gettimeofday (&toc, NULL);
+                theory_time += toc.tv_sec - tic.tv_sec;
+                theory_time += (double) (toc.tv_usec - tic.tv_usec) / 1000000;
+            }
+            add_core(negate_vids);
         }
         assert (negate_vids.size() > 0);
         for (int i=0; i < negate_vids.size(); i++) {
@@ -353,6 +535,8 @@ bool Metric_TSP_Theory::minisat_check_conflict_cb (const VMap<lbool> &assigns, c
  ****************************************************************/
 MST_Theory::MST_Theory (TSP *graph, int verbose_level)
     : graph(graph)
+    , mst(new MST(graph))
+    , mst_valid(true)
 {}
 
 /************************************************************//**
@@ -384,7 +568,7 @@ void MST_Theory::minisat_trail_push_cb (const VMap<lbool> &assigns, const vec<Li
 
         // solve MST
         clock_t tic = clock();
-        if (mst_valid) {
+        if (mst_valid && mst->size() == soln_vids.size()-1) {
             mst->insert(push_vid);
             assert (mst->size() == soln_vids.size());
             #ifdef DEBUG
@@ -400,8 +584,11 @@ void MST_Theory::minisat_trail_push_cb (const VMap<lbool> &assigns, const vec<Li
                 assert (test_mst.cost() == mst->cost());
             #endif
         } else {
+            // rebuild by insertion so that the tree can be undone again
             delete mst;
-            mst       = new MST(graph, soln_vids);
+            mst       = new MST(graph);
+            for (int i=0; i<soln_vids.size(); i++)
+                mst->insert(soln_vids[i]);
             mst_valid = true;
         }
         conflict = (2*mst->cost() > tsp_cost_budget);
@@ -421,6 +608,14 @@ void MST_Theory::minisat_trail_shrink_cb (const VMap<lbool> &assigns, const vec<
         if (!sign(lit) && vid >= 0) {
             soln_vids.pop_back();
             conflict = false;
+
+            // follow the trail back, the tree is exactly the one we had
+            clock_t tic = clock();
+            if (mst_valid && mst->size() == soln_vids.size()+1)
+                mst->undo();
+            else
+                mst_valid = false;
+            theory_time += (double)(clock()-tic)/CLOCKS_PER_SEC;
         }
     }
   
@@ -466,6 +661,223 @@ bool MST_Theory::minisat_check_conflict_cb (const VMap<lbool> &assigns, const ve
 
 
 
+/****************************************************************
+ * Held-Karp Theory
+ *
+ *
+ *
+ ****************************************************************/
+
+/************************************************************//**
+ * @brief	
+ * @version						v0.01b
+ ****************************************************************/
+Held_Karp_Theory::Held_Karp_Theory (TSP *graph, int iterations, int verbose_level)
+    : graph(graph)
+    , conflict(false)
+    , conflict_checked(false)
+    , iterations(iterations)
+{}
+
+/************************************************************//**
+ * @brief	
+ * @version						v0.01b
+ ****************************************************************/
+void Held_Karp_Theory::reset() {
+    soln_vids.clear();
+    subgraph_of.assign(graph->size(), -1);
+    for (int i=graph->subgraphs.size()-1; i>=0; i--)
+        for (int j=0; j<graph->subgraphs[i].size(); j++)
+            subgraph_of[graph->subgraphs[i][j]] = i;
+    bounds.assign(graph->subgraphs.size(), 0);
+    penalty.assign(graph->size(), 0.0);
+    conflict = false;
+    conflict_checked = false;
+}
+
+/************************************************************//**
+ * @brief	Minimum 1-tree under the current penalties
+ * @version						v0.01b
+ * Spanning tree of vids[1..k) (dense Prim) plus the two cheapest
+ * edges of vids[0]. Returns the penalized cost minus twice the sum
+ * of penalties, a lower bound on any tour through vids.
+ ****************************************************************/
+double Held_Karp_Theory::one_tree (const vector<int> &vids, vector<int> &degree) {
+    int k = vids.size();
+    degree.assign(k, 0);
+    vector<double> key(k, 1e300);
+    vector<int> from(k, -1);
+    vector<bool> in_tree(k, false);
+    double cost = 0;
+
+    // spanning tree over vids[1..k)
+    int last = 1;
+    in_tree[last] = true;
+    for (int n=2; n<k; n++) {
+        int best = -1;
+        for (int i=1; i<k; i++) {
+            if (in_tree[i])
+                continue;
+            double w = graph->edge_weight(vids[last],vids[i]) + penalty[vids[last]] + penalty[vids[i]];
+            if (w < key[i]) {
+                key[i]  = w;
+                from[i] = last;
+            }
+            if (best < 0 || key[i] < key[best])
+                best = i;
+        }
+        in_tree[best] = true;
+        cost += key[best];
+        degree[best]++;
+        degree[from[best]]++;
+        last = best;
+    }
+
+    // two cheapest edges of the special vertex
+    double first(1e300), second(1e300);
+    int first_i(-1), second_i(-1);
+    for (int i=1; i<k; i++) {
+        double w = graph->edge_weight(vids[0],vids[i]) + penalty[vids[0]] + penalty[vids[i]];
+        if (w < first) {
+            second   = first;
+            second_i = first_i;
+            first    = w;
+            first_i  = i;
+        } else if (w < second) {
+            second   = w;
+            second_i = i;
+        }
+    }
+    cost += first + second;
+    degree[0] += 2;
+    degree[first_i]++;
+    degree[second_i]++;
+
+    for (int i=0; i<k; i++)
+        cost -= 2*penalty[vids[i]];
+    return cost;
+}
+
+/************************************************************//**
+ * @brief	A few subgradient steps, returns the best integer bound
+ * @version						v0.01b
+ * Polyak steps towards target+1, stopping as soon as the bound
+ * exceeds target or the 1-tree is a tour.
+ ****************************************************************/
+int Held_Karp_Theory::ascent (const vector<int> &vids, int target) {
+    int k = vids.size();
+    if (k < 2)
+        return 0;
+    if (k == 2)
+        return graph->edge_weight(vids[0],vids[1]) + graph->edge_weight(vids[1],vids[0]);
+
+    vector<int> degree;
+    double best = 0;
+    for (int iter=0; iter < max(iterations,1); iter++) {
+        double bound = one_tree(vids, degree);
+        best = max(best, bound);
+        if (best > target)
+            break;
+        int norm = 0;
+        for (int i=0; i<k; i++)
+            norm += (degree[i]-2)*(degree[i]-2);
+        if (norm == 0)
+            break;
+        double step = (target + 1 - bound) / norm;
+        for (int i=0; i<k; i++)
+            penalty[vids[i]] += step * (degree[i]-2);
+    }
+    return (int) ceil(best - 1e-6);
+}
+
+/************************************************************//**
+ * @brief	
+ * @version						v0.01b
+ ****************************************************************/
+void Held_Karp_Theory::minisat_trail_push_cb (const VMap<lbool> &assigns, const vec<Lit>& trail, vec<Lit>& propagate_list) {
+    Lit push_lit = trail.last();
+    int push_vid = graph->var2vid(var(push_lit));
+
+    if (!sign(push_lit) && push_vid >= 0) {
+        soln_vids.push_back(push_vid);
+        int s = subgraph_of[push_vid];
+        if (conflict || s < 0)
+            return;
+
+        clock_t tic = clock();
+        vector<int> vids;
+        for (int i=0; i<soln_vids.size(); i++)
+            if (subgraph_of[soln_vids[i]] == s)
+                vids.push_back(soln_vids[i]);
+
+        // bound this subgraph against what is left of the budgets
+        int others = 0;
+        for (int i=0; i<bounds.size(); i++)
+            if (i != s)
+                others += bounds[i];
+        int target = min(subgraph_cost_budget, tsp_cost_budget - others);
+        bounds[s]  = ascent(vids, target);
+
+        if (bounds[s] > subgraph_cost_budget) {
+            conflict      = true;
+            conflict_vids = vids;
+        } else if (bounds[s] + others > tsp_cost_budget) {
+            conflict      = true;
+            conflict_vids.clear();
+            for (int i=0; i<soln_vids.size(); i++)
+                if (subgraph_of[soln_vids[i]] >= 0 && bounds[subgraph_of[soln_vids[i]]] > 0)
+                    conflict_vids.push_back(soln_vids[i]);
+        }
+        conflict_checked = false;
+        theory_time += (double)(clock()-tic)/CLOCKS_PER_SEC;
+
+        #ifdef MINISAT_VERBOSE
+            printf("Held_Karp::push_vid(%d) bound = %d\n", push_vid, bounds[s]);
+        #endif
+    }
+}
+
+/************************************************************//**
+ * @brief	
+ * @version						v0.01b
+ ****************************************************************/
+void Held_Karp_Theory::minisat_trail_shrink_cb (const VMap<lbool> &assigns, const vec<Lit> &trail, int amount) {
+    for (int i=0; i<amount; i++) {
+        Lit lit  = trail[trail.size()-i-1];
+        int vid = graph->var2vid(var(lit));
+        if (!sign(lit) && vid >= 0) {
+            soln_vids.pop_back();
+            if (subgraph_of[vid] >= 0)
+                bounds[subgraph_of[vid]] = 0;
+            conflict = false;
+        }
+    }
+}
+
+/************************************************************//**
+ * @brief	
+ * @version						v0.01b
+ ****************************************************************/
+bool Held_Karp_Theory::minisat_check_conflict_cb (const VMap<lbool> &assigns, const vec<Lit> &trail, vec<Lit> &conflict_list) {
+    if (conflict_checked)
+        return false;
+    conflict_checked = true;
+    conflict_list.clear();
+
+    if (conflict) {
+        for (int i=0; i < conflict_vids.size(); i++)
+            conflict_list.push(mkLit(graph->vid2var(conflict_vids[i]),true));
+        #ifdef MINISAT_VERBOSE
+            printf("Held_Karp::cost_conflict()\n");
+        #endif
+        return true;
+    }
+    return false;
+}
+
+
+
+
 /****************************************************************
  * Cardinality Equals Theory
  *
@@ -0,0 +1,124 @@
+/********************************************************************************
+  Copyright 2017 Frank Imeson and Stephen L. Smith
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*********************************************************************************/
+
+
+#include "thread_pool.hpp"
+
+/********************************************************************************
+ * 
+ * ThreadPool Class
+ * 
+ ********************************************************************************/         
+
+
+/************************************************************//**
+ * @brief	threads counts the calling thread, so threads-1 workers
+ *          are started
+ * @version						v0.01b
+ ****************************************************************/
+ThreadPool::ThreadPool (int threads)
+  : stopping(false)
+{
+  for (int i=1; i<threads; i++)
+    workers.push_back(thread(&ThreadPool::worker, this));
+}
+
+
+/************************************************************//**
+ * @brief	
+ * @version						v0.01b
+ ****************************************************************/
+ThreadPool::~ThreadPool ()
+{
+  {
+    unique_lock<mutex> lock(m);
+    stopping = true;
+  }
+  wake.notify_all();
+  for (int i=0; i<workers.size(); i++)
+    workers[i].join();
+}
+
+
+/************************************************************//**
+ * @brief	Run job(0), ..., job(n-1) and wait for all of them
+ * @version						v0.01b
+ ****************************************************************/
+void ThreadPool::run (int n, const function<void(int)> &job)
+{
+  if (n <= 0)
+    return;
+
+  shared_ptr<Batch> batch(new Batch);
+  batch->size = n;
+  batch->job  = &job;
+  batch->next = 0;
+  batch->done = 0;
+
+  int helpers = min(n-1, int(workers.size()));
+  if (helpers > 0) {
+    {
+      unique_lock<mutex> lock(m);
+      for (int i=0; i<helpers; i++)
+        tasks.push(batch);
+    }
+    wake.notify_all();
+  }
+
+  drain(*batch);
+  unique_lock<mutex> lock(batch->m);
+  while (batch->done < n)
+    batch->finished.wait(lock);
+}
+
+
+/************************************************************//**
+ * @brief	Take jobs from batch until none are left
+ * @version						v0.01b
+ ****************************************************************/
+void ThreadPool::drain (Batch &batch)
+{
+  int i;
+  while ((i = batch.next++) < batch.size) {
+    (*batch.job)(i);
+    if (++batch.done == batch.size) {
+      unique_lock<mutex> lock(batch.m);
+      batch.finished.notify_all();
+    }
+  }
+}
+
+
+/************************************************************//**
+ * @brief	
+ * @version						v0.01b
+ ****************************************************************/
+void ThreadPool::worker ()
+{
+  while (true) {
+    shared_ptr<Batch> batch;
+    {
+      unique_lock<mutex> lock(m);
+      while (!stopping && tasks.empty())
+        wake.wait(lock);
+      if (stopping && tasks.empty())
+        return;
+      batch = tasks.front();
+      tasks.pop();
+    }
+    drain(*batch);
+  }
+}
@@ -25,13 +25,117 @@
  * @brief	
  * @version						v0.01b
  ****************************************************************/
-string get_token(string line) {
-  int i = line.find(':')+1;
-  int j = line.find_last_not_of(' ')+1;
-  if (line[i] == ' ') {
-    i += line.substr(i,j).find_first_not_of(' ');
-  }
-  return line.substr(i,j-i);
+static inline bool is_digit(char c) {
+  return (unsigned char)(c - '0') <= 9;
+}
+
+
+/************************************************************//**
+ * @brief	Skip blanks, but not the end of the line
+ * @version						v0.01b
+ ****************************************************************/
+static inline const char* skip_space(const char *p, const char *end) {
+  while (p < end && (*p == ' ' || *p == '\t' || *p == '\r'))
+    p++;
+  return p;
+}
+
+
+/************************************************************//**
+ * @brief	Match a header line "KEY [:] VALUE"
+ * @version						v0.01b
+ * p points at the first non-blank character of the line.
+ ****************************************************************/
+static bool parse_keyword(const char *p, const char *end, const char *key, string &value) {
+  size_t length = strlen(key);
+  if (end-p < length || strncmp(p, key, length) != 0)
+    return false;
+  p += length;
+  const char *q = skip_space(p, end);
+  if (q < end && *q == ':')
+    q = skip_space(q+1, end);
+  else if (q == p)
+    return false;  // longer keyword
+  while (end > q && isspace(end[-1]))
+    end--;
+  if (end == q)
+    return false;
+  value.assign(q, end);
+  return true;
+}
+
+
+/************************************************************//**
+ * @brief	Match a section line "KEY [:]"
+ * @version						v0.01b
+ ****************************************************************/
+static bool parse_section(const char *p, const char *end, const char *key) {
+  size_t length = strlen(key);
+  if (end-p < length || strncmp(p, key, length) != 0)
+    return false;
+  p = skip_space(p+length, end);
+  if (p < end && *p == ':')
+    p = skip_space(p+1, end);
+  return p == end;
+}
+
+
+/************************************************************//**
+ * @brief	Read a blank separated integer and advance p past it
+ * @version						v0.01b
+ ****************************************************************/
+static bool parse_int(const char *&p, const char *end, int &x) {
+  const char *q = skip_space(p, end);
+  bool negative = (q < end && *q == '-');
+  if (negative)
+    q++;
+  if (q == end || !is_digit(*q))
+    return false;
+  x = 0;
+  while (q < end && is_digit(*q))
+    x = 10*x + (*q++ - '0');
+  if (q < end && !isspace(*q))
+    return false;
+  if (negative)
+    x = -x;
+  p = q;
+  return true;
+}
+
+
+/************************************************************//**
+ * @brief	Read a blank separated real number and advance p past it
+ * @version						v0.01b
+ ****************************************************************/
+static bool parse_double(const char *&p, const char *end, double &x) {
+  const char *q = skip_space(p, end);
+  const char *token_end = q;
+  while (token_end < end && !isspace(*token_end))
+    token_end++;
+  char buffer[64];
+  if (token_end == q || token_end-q >= sizeof(buffer))
+    return false;
+  memcpy(buffer, q, token_end-q);
+  buffer[token_end-q] = '\0';
+  char *parsed;
+  x = strtod(buffer, &parsed);
+  if (*parsed != '\0')
+    return false;
+  p = token_end;
+  return true;
+}
+
+
+/************************************************************//**
+ * @brief	Read the leading blank separated integers of a line
+ * @version						v0.01b
+ ****************************************************************/
+static int parse_ints(const char *p, const char *end, vector<int> &data) {
+  int x;
+  data.clear();
+  while (parse_int(p, end, x))
+    data.push_back(x);
+  return data.size();
 }
 
 
@@ -98,7 +202,7 @@ bool TSP::get_tour_cost(const vector<int> &tour, int &tsp_cost, int &max_subgrap
         for (int j=0; j<sub_tours[i].size(); j++) {
           vid00 = sub_tours[i][j];
           vid01 = sub_tours[i][(j+1)%sub_tours[i].size()];
-          tour_cost += edge_weight[vid00][vid01];
+          tour_cost += edge_weight(vid00,vid01);
         }
         tsp_cost += tour_cost;
         max_subgraph_cost = max(tour_cost, max_subgraph_cost);
@@ -132,11 +236,549 @@ bool TSP::feasible(const vector<int> &soln_tour, const int tsp_cost_budget, cons
 }
 
 
+/************************************************************//**
+ * @brief	Reallocate as an n x n int32 matrix filled with value
+ * @version						v0.01b
+ ****************************************************************/
+void Weight_Matrix::resize (int n, int value) {
+  if (!mapped)
+    free(data);
+  mapped    = false;
+  data      = NULL;
+  wide      = true;
+  kind      = WEIGHT_EXPLICIT;
+  this->n   = n;
+  x.clear();
+  y.clear();
+  stride    = (n + CACHE_LINE/4 - 1) / (CACHE_LINE/4) * (CACHE_LINE/4);
+  if (n == 0)
+    return;
+  if (posix_memalign(&data, CACHE_LINE, size_t(n)*stride*sizeof(int32_t)) != 0) {
+    cerr << "error: could not allocate weight matrix\n";
+    exit(1);
+  }
+  std::fill((int32_t*) data, (int32_t*) data + size_t(n)*stride, int32_t(value));
+}
+
+
 /************************************************************//**
  * @brief	
  * @version						v0.01b
  ****************************************************************/
-bool TSP::LKH(const vector<int> &vids, const int &max_cost, vector<int> &soln_tour, int &soln_cost) {
+void Weight_Matrix::set (int i, int j, int w) {
+  if (lazy())
+    materialize();
+  if (!wide && w < INF && (w >= INT16_MAX || w < INT16_MIN)) {
+    // widen back to int32
+    Weight_Matrix copy;
+    copy.resize(n);
+    for (int x=0; x<n; x++)
+      for (int y=0; y<n; y++)
+        copy.set(x, y, (*this)(x,y));
+    std::swap(data, copy.data);
+    std::swap(stride, copy.stride);
+    std::swap(mapped, copy.mapped);
+    wide = true;
+  }
+  size_t k = size_t(i)*stride + j;
+  if (wide)
+    ((int32_t*) data)[k] = w;
+  else
+    ((int16_t*) data)[k] = (w >= INF) ? INT16_MAX : w;
+}
+
+
+/************************************************************//**
+ * @brief	Switch to int16 storage if all finite weights fit
+ * @version						v0.01b
+ ****************************************************************/
+bool Weight_Matrix::compact () {
+  if (!wide || data == NULL)
+    return !wide;
+  for (int i=0; i<n; i++) {
+    for (int j=0; j<n; j++) {
+      int w = (*this)(i,j);
+      if (w < INF && (w >= INT16_MAX || w < INT16_MIN))
+        return false;
+    }
+  }
+
+  int narrow_stride = (n + CACHE_LINE/2 - 1) / (CACHE_LINE/2) * (CACHE_LINE/2);
+  void *narrow;
+  if (posix_memalign(&narrow, CACHE_LINE, size_t(n)*narrow_stride*sizeof(int16_t)) != 0)
+    return false;
+  for (int i=0; i<n; i++) {
+    for (int j=0; j<n; j++) {
+      int w = (*this)(i,j);
+      ((int16_t*) narrow)[size_t(i)*narrow_stride + j] = (w >= INF) ? INT16_MAX : w;
+    }
+  }
+  if (!mapped)
+    free(data);
+  mapped  = false;
+  data    = narrow;
+  stride  = narrow_stride;
+  wide    = false;
+  return true;
+}
+
+
+static std::atomic<int> next_cache_id(1);    // of lazy matrices, keys the row caches
+
+
+/************************************************************//**
+ * @brief	Keep only the coordinates, weights are computed on demand
+ * @version						v0.01b
+ ****************************************************************/
+void Weight_Matrix::set_coordinates (int kind, const vector< vector<double> > &coords) {
+  resize(0);
+  this->kind  = kind;
+  n           = coords.size();
+  cache_id    = next_cache_id++;
+  x.resize(n);
+  y.resize(n);
+  for (int i=0; i<n; i++) {
+    if (kind == WEIGHT_GEO) {
+      // latitude and longitude in radians
+      double PI = 3.141592;
+      double deg(0), min(0);
+      extract_deg_min(coords[i][0], deg, min);
+      x[i] = PI * (deg + 5.0 * min / 3.0) / 180.0;
+      extract_deg_min(coords[i][1], deg, min);
+      y[i] = PI * (deg + 5.0 * min / 3.0) / 180.0;
+    } else {
+      x[i] = coords[i][0];
+      y[i] = coords[i][1];
+    }
+  }
+}
+
+
+/************************************************************//**
+ * @brief	Use a stored table (or coordinates if NULL) in place
+ * @version						v0.01b
+ * The table is laid out as by resize() or compact() for the given
+ * width, GEO coordinates are in radians.
+ ****************************************************************/
+void Weight_Matrix::map (int n, int kind, int width, int stride, void *table, const double *x, const double *y) {
+  resize(0);
+  this->n       = n;
+  this->kind    = kind;
+  this->stride  = stride;
+  wide          = (width == 32);
+  data          = table;
+  mapped        = (table != NULL);
+  if (table == NULL) {
+    cache_id    = next_cache_id++;
+    this->x.assign(x, x+n);
+    this->y.assign(y, y+n);
+  }
+}
+
+
+/************************************************************//**
+ * @brief	TSPLIB distance between two coordinates
+ * @version						v0.01b
+ ****************************************************************/
+int Weight_Matrix::distance (int i, int j) const {
+  if (i == j)
+    return INF;
+
+  if (kind == WEIGHT_GEO) {
+    double RRR = 6378.388;
+    double q1 = cos(y[i] - y[j]);
+    double q2 = cos(x[i] - x[j]);
+    double q3 = cos(x[i] + x[j]);
+    return int(RRR * acos(0.5*((1.0+q1)*q2 - (1.0-q1)*q3) ) + 1.0);
+  }
+
+  double dx = x[i] - x[j];
+  double dy = y[i] - y[j];
+  if (kind == WEIGHT_ATT) {
+    double r = sqrt(dx*dx/10.0 + dy*dy/10.0);
+    int weight = nint(r);
+    if (weight < r) {
+      weight++;
+    }
+    return weight;
+  } else if (kind == WEIGHT_CEIL_2D) {
+    return ceil(sqrt(pow(dx,2) + pow(dy,2)));
+  }
+  return nint(sqrt(pow(dx,2) + pow(dy,2)));
+}
+
+
+/************************************************************//**
+ * @brief	Row kernels: fill row[0..k) with the distances from
+ *        (xi,yi) and return k, the rest is left to the caller
+ * @version						v0.01b
+ * Same operations in the same order as Weight_Matrix::distance(),
+ * without fused multiply-add, so the rounded weights are identical.
+ ****************************************************************/
+typedef int (*Row_Kernel)(int kind, double xi, double yi, const double *x, const double *y, int n, int32_t *row);
+
+static int row_kernel_scalar(int kind, double xi, double yi, const double *x, const double *y, int n, int32_t *row) {
+  return 0;
+}
+
+#ifdef DISTANCE_SIMD
+__attribute__((target("avx2")))
+static int row_kernel_avx2(int kind, double xi, double yi, const double *x, const double *y, int n, int32_t *row) {
+  const __m256d vxi = _mm256_set1_pd(xi);
+  const __m256d vyi = _mm256_set1_pd(yi);
+  const __m256d half = _mm256_set1_pd(0.5);
+  const __m256d one = _mm256_set1_pd(1.0);
+  const __m256d ten = _mm256_set1_pd(10.0);
+  int j = 0;
+  for (; j+4 <= n; j+=4) {
+    __m256d dx = _mm256_sub_pd(vxi, _mm256_loadu_pd(x+j));
+    __m256d dy = _mm256_sub_pd(vyi, _mm256_loadu_pd(y+j));
+    __m256d w;
+    if (kind == WEIGHT_ATT) {
+      __m256d r = _mm256_sqrt_pd(_mm256_add_pd(_mm256_div_pd(_mm256_mul_pd(dx,dx), ten),
+                                                _mm256_div_pd(_mm256_mul_pd(dy,dy), ten)));
+      w = _mm256_floor_pd(_mm256_add_pd(r, half));
+      w = _mm256_add_pd(w, _mm256_and_pd(_mm256_cmp_pd(w, r, _CMP_LT_OQ), one));
+    } else {
+      __m256d r = _mm256_sqrt_pd(_mm256_add_pd(_mm256_mul_pd(dx,dx), _mm256_mul_pd(dy,dy)));
+      if (kind == WEIGHT_CEIL_2D)
+        w = _mm256_ceil_pd(r);
+      else
+        w = _mm256_floor_pd(_mm256_add_pd(r, half));
+    }
+    _mm_storeu_si128((__m128i*) (row+j), _mm256_cvttpd_epi32(w));
+  }
+  return j;
+}
+
+__attribute__((target("sse4.1")))
+static int row_kernel_sse41(int kind, double xi, double yi, const double *x, const double *y, int n, int32_t *row) {
+  const __m128d vxi = _mm_set1_pd(xi);
+  const __m128d vyi = _mm_set1_pd(yi);
+  const __m128d half = _mm_set1_pd(0.5);
+  const __m128d one = _mm_set1_pd(1.0);
+  const __m128d ten = _mm_set1_pd(10.0);
+  int j = 0;
+  for (; j+2 <= n; j+=2) {
+    __m128d dx = _mm_sub_pd(vxi, _mm_loadu_pd(x+j));
+    __m128d dy = _mm_sub_pd(vyi, _mm_loadu_pd(y+j));
+    __m128d w;
+    if (kind == WEIGHT_ATT) {
+      __m128d r = _mm_sqrt_pd(_mm_add_pd(_mm_div_pd(_mm_mul_pd(dx,dx), ten),
+                                         _mm_div_pd(_mm_mul_pd(dy,dy), ten)));
+      w = _mm_floor_pd(_mm_add_pd(r, half));
+      w = _mm_add_pd(w, _mm_and_pd(_mm_cmplt_pd(w, r), one));
+    } else {
+      __m128d r = _mm_sqrt_pd(_mm_add_pd(_mm_mul_pd(dx,dx), _mm_mul_pd(dy,dy)));
+      if (kind == WEIGHT_CEIL_2D)
+        w = _mm_ceil_pd(r);
+      else
+        w = _mm_floor_pd(_mm_add_pd(r, half));
+    }
+    _mm_storel_epi64((__m128i*) (row+j), _mm_cvttpd_epi32(w));
+  }
+  return j;
+}
+#endif
+
+/************************************************************//**
+ * @brief	Triangle kernels: whether w + row01[k] - row00[k] < -1
+ *        for any k in [0,n)
+ * @version						v0.01b
+ ****************************************************************/
+typedef bool (*Triangle_Kernel)(int32_t w, const int32_t *row00, const int32_t *row01, int n);
+
+static bool triangle_kernel_scalar(int32_t w, const int32_t *row00, const int32_t *row01, int n) {
+  int hit = 0;
+  for (int k=0; k<n; k++)
+    hit |= (w + row01[k] - row00[k] < -1);
+  return hit;
+}
+
+#ifdef DISTANCE_SIMD
+__attribute__((target("avx2")))
+static bool triangle_kernel_avx2(int32_t w, const int32_t *row00, const int32_t *row01, int n) {
+  const __m256i vw = _mm256_set1_epi32(w);
+  const __m256i minus_one = _mm256_set1_epi32(-1);
+  __m256i hit = _mm256_setzero_si256();
+  int k = 0;
+  for (; k+8 <= n; k+=8) {
+    __m256i v = _mm256_sub_epi32(_mm256_add_epi32(vw, _mm256_loadu_si256((const __m256i*) (row01+k))),
+                                 _mm256_loadu_si256((const __m256i*) (row00+k)));
+    hit = _mm256_or_si256(hit, _mm256_cmpgt_epi32(minus_one, v));
+  }
+  return !_mm256_testz_si256(hit, hit) || triangle_kernel_scalar(w, row00+k, row01+k, n-k);
+}
+
+__attribute__((target("sse4.1")))
+static bool triangle_kernel_sse41(int32_t w, const int32_t *row00, const int32_t *row01, int n) {
+  const __m128i vw = _mm_set1_epi32(w);
+  const __m128i minus_one = _mm_set1_epi32(-1);
+  __m128i hit = _mm_setzero_si128();
+  int k = 0;
+  for (; k+4 <= n; k+=4) {
+    __m128i v = _mm_sub_epi32(_mm_add_epi32(vw, _mm_loadu_si128((const __m128i*) (row01+k))),
+                              _mm_loadu_si128((const __m128i*) (row00+k)));
+    hit = _mm_or_si128(hit, _mm_cmplt_epi32(v, minus_one));
+  }
+  return !_mm_testz_si128(hit, hit) || triangle_kernel_scalar(w, row00+k, row01+k, n-k);
+}
+#endif
+
+static Triangle_Kernel select_triangle_kernel() {
+  #ifdef DISTANCE_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+      return triangle_kernel_avx2;
+    if (__builtin_cpu_supports("sse4.1"))
+      return triangle_kernel_sse41;
+  #endif
+  return triangle_kernel_scalar;
+}
+
+static Row_Kernel select_row_kernel() {
+  #ifdef DISTANCE_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+      return row_kernel_avx2;
+    if (__builtin_cpu_supports("sse4.1"))
+      return row_kernel_sse41;
+  #endif
+  return row_kernel_scalar;
+}
+
+
+/************************************************************//**
+ * @brief	Weights from vertex i to every vertex
+ * @version						v0.01b
+ * EUC_2D, ATT and CEIL_2D rows go through the widest row kernel the
+ * cpu supports, GEO and the remainder are computed one at a time.
+ ****************************************************************/
+void Weight_Matrix::compute_row (int i, int32_t *row) const {
+  static const Row_Kernel kernel = select_row_kernel();
+
+  if (data != NULL || kind == WEIGHT_EXPLICIT) {
+    for (int j=0; j<n; j++)
+      row[j] = (*this)(i,j);
+    return;
+  }
+  int j = 0;
+  if (kind != WEIGHT_GEO)
+    j = kernel(kind, x[i], y[i], &x[0], &y[0], n, row);
+  for (; j<n; j++)
+    row[j] = distance(i,j);
+  row[i] = INF;
+}
+
+
+/************************************************************//**
+ * @brief	Row i as int32, in place when stored that way, else in buffer
+ * @version						v0.01b
+ ****************************************************************/
+const int32_t* Weight_Matrix::row (int i, int32_t *buffer) const {
+  if (data != NULL && wide)
+    return (const int32_t*) data + size_t(i)*stride;
+  compute_row(i, buffer);
+  return buffer;
+}
+
+
+/************************************************************//**
+ * @brief	Lazy weight lookup through the calling thread's row cache
+ * @version						v0.01b
+ * The cache is direct mapped (row i lives in slot i % rows) and
+ * belongs to whichever lazy matrix the thread used last.
+ ****************************************************************/
+int Weight_Matrix::lazy_weight (int i, int j) const {
+  struct Row_Cache {
+    int               id;
+    vector<int>       tags;
+    vector<int32_t>   rows;
+  };
+  static thread_local Row_Cache row_cache = {0, vector<int>(), vector<int32_t>()};
+
+  if (cache_rows == 0 || kind == WEIGHT_EXPLICIT)
+    return (kind == WEIGHT_EXPLICIT) ? -1 : distance(i,j);
+
+  if (row_cache.id != cache_id || (int) row_cache.tags.size() != cache_rows) {
+    row_cache.id = cache_id;
+    row_cache.tags.assign(cache_rows, -1);
+    row_cache.rows.resize(size_t(cache_rows)*n);
+  }
+  int slot = i % cache_rows;
+  int32_t *row = &row_cache.rows[size_t(slot)*n];
+  if (row_cache.tags[slot] != i) {
+    compute_row(i, row);
+    row_cache.tags[slot] = i;
+  }
+  return row[j];
+}
+
+
+/************************************************************//**
+ * @brief	Fill the full table from the coordinates
+ * @version						v0.01b
+ ****************************************************************/
+void Weight_Matrix::materialize () {
+  if (!lazy())
+    return;
+  stride = (n + CACHE_LINE/4 - 1) / (CACHE_LINE/4) * (CACHE_LINE/4);
+  if (n == 0)
+    return;
+  void *table;
+  if (posix_memalign(&table, CACHE_LINE, size_t(n)*stride*sizeof(int32_t)) != 0) {
+    cerr << "error: could not allocate weight matrix\n";
+    exit(1);
+  }
+
+  // rows are independent, split them over the available cores
+  int threads = min<int>(thread::hardware_concurrency(), n / 512);
+  if (threads > 1) {
+    int chunk = 64;
+    ThreadPool pool(threads);
+    pool.run((n + chunk - 1) / chunk, [&](int c) {
+      for (int i=c*chunk; i < min(n, (c+1)*chunk); i++)
+        compute_row(i, (int32_t*) table + size_t(i)*stride);
+    });
+  } else {
+    for (int i=0; i<n; i++)
+      compute_row(i, (int32_t*) table + size_t(i)*stride);
+  }
+  data = table;
+  wide = true;
+  compact();
+}
+
+
+/************************************************************//**
+ * @brief	
+ * @version						v0.01b
+ ****************************************************************/
+size_t TSP_Cache::Hash::operator() (const vector<int> &key) const {
+  size_t h = key.size();
+  for (unsigned int i=0; i<key.size(); i++)
+    h ^= size_t(key[i]) + 0x9e3779b9 + (h << 6) + (h >> 2);
+  return h;
+}
+
+
+/************************************************************//**
+ * @brief	Resize the cache, evicting least recently used entries
+ * @version						v0.01b
+ ****************************************************************/
+void TSP_Cache::set_capacity(int x) {
+  capacity = max(x, 0);
+  while (int(entries.size()) > capacity) {
+    index.erase(entries.back().key);
+    entries.pop_back();
+  }
+}
+
+
+/************************************************************//**
+ * @brief	Find (or create) the entry for key and mark it most recently used
+ * @version						v0.01b
+ ****************************************************************/
+TSP_Cache::Entry& TSP_Cache::touch(const vector<int> &key) {
+  unordered_map<vector<int>, list<Entry>::iterator, Hash>::iterator it = index.find(key);
+  if (it != index.end()) {
+    entries.splice(entries.begin(), entries, it->second);
+    return entries.front();
+  }
+
+  if (int(entries.size()) >= capacity) {
+    index.erase(entries.back().key);
+    entries.pop_back();
+  }
+  Entry entry;
+  entry.key = key;
+  entry.cost = INF;
+  entry.infeasible_cost = -1;
+  entry.infeasible_epoch = epoch;
+  entries.push_front(entry);
+  index[key] = entries.begin();
+  return entries.front();
+}
+
+
+/************************************************************//**
+ * @brief	Answer a "tour within max_cost?" query from the cache
+ * @version						v0.01b
+ * Returns true if the query was answered, in which case feasible
+ * holds the answer and soln_tour/soln_cost the cached tour.
+ ****************************************************************/
+bool TSP_Cache::lookup(const vector<int> &key, const int &max_cost, vector<int> &soln_tour, int &soln_cost, bool &feasible) {
+  if (capacity == 0)
+    return false;
+
+  unordered_map<vector<int>, list<Entry>::iterator, Hash>::iterator it = index.find(key);
+  if (it == index.end()) {
+    misses++;
+    return false;
+  }
+  entries.splice(entries.begin(), entries, it->second);
+  Entry &entry = entries.front();
+
+  if (entry.tour.size() > 0 && entry.cost <= max_cost) {
+    soln_tour = entry.tour;
+    soln_cost = entry.cost;
+    feasible = true;
+  } else if (entry.infeasible_epoch == epoch && max_cost <= entry.infeasible_cost) {
+    if (entry.tour.size() > 0)
+      soln_cost = entry.cost;
+    feasible = false;
+  } else {
+    misses++;
+    return false;
+  }
+  hits++;
+  return true;
+}
+
+
+/************************************************************//**
+ * @brief	Record a tour, keeping the cheapest one seen per key
+ * @version						v0.01b
+ ****************************************************************/
+void TSP_Cache::insert_tour(const vector<int> &key, const vector<int> &tour, const int &cost) {
+  if (capacity == 0)
+    return;
+  Entry &entry = touch(key);
+  if (entry.tour.size() == 0 || cost < entry.cost) {
+    entry.tour = tour;
+    entry.cost = cost;
+  }
+}
+
+
+/************************************************************//**
+ * @brief	Record that LKH could not find a tour within max_cost
+ * @version						v0.01b
+ * Not a proof, the record only lasts for the current epoch.
+ ****************************************************************/
+void TSP_Cache::insert_infeasible(const vector<int> &key, const int &max_cost) {
+  if (capacity == 0)
+    return;
+  Entry &entry = touch(key);
+  if (entry.infeasible_epoch != epoch) {
+    entry.infeasible_cost = -1;
+    entry.infeasible_epoch = epoch;
+  }
+  entry.infeasible_cost = max(entry.infeasible_cost, max_cost);
+}
+
+
+/************************************************************//**
+ * @brief	
+ * @version						v0.01b
+ * If given, initial_tour warm starts LKH: vertices not in vids are
+ * skipped and missing ones are inserted at their cheapest position.
+ * A warm tour already within max_cost is returned without LKH.
+ * With set_lkh_seeds(k), k runs with different seeds share the
+ * pool and the first within max_cost stops the others. On failure
+ * soln_tour and soln_cost hold the best tour found.
+ ****************************************************************/
+bool TSP::LKH(const vector<int> &vids, const int &max_cost, vector<int> &soln_tour, int &soln_cost, const atomic<int> *cancel, const vector<int> *initial_tour) {
 
   vector<int> sorted_vids;
   for (unsigned int i=0; i<vids.size(); i++) {
@@ -163,7 +805,7 @@ bool TSP::LKH(const vector<int> &vids, const int &max_cost, vector<int> &soln_to
     return true;
   } else if (vids.size() == 2) {
     int x(vids[0]), y(vids[1]);
-    soln_cost = edge_weight[x][y] + edge_weight[y][x];
+    soln_cost = edge_weight(x,y) + edge_weight(y,x);
     if (soln_cost <= max_cost) {
       soln_tour.clear();
       soln_tour.push_back(x);
@@ -174,8 +816,8 @@ bool TSP::LKH(const vector<int> &vids, const int &max_cost, vector<int> &soln_to
     }
   } else if (vids.size() == 3) {
     int x(vids[0]), y(vids[1]), z(vids[2]);
-    int cost01 = edge_weight[x][y] + edge_weight[y][z] + edge_weight[z][x];
-    int cost02 = edge_weight[x][z] + edge_weight[z][y] + edge_weight[y][x];
+    int cost01 = edge_weight(x,y) + edge_weight(y,z) + edge_weight(z,x);
+    int cost02 = edge_weight(x,z) + edge_weight(z,y) + edge_weight(y,x);
     soln_cost = min(cost01, cost02);
     if (soln_cost <= max_cost) {
       soln_tour.clear();
@@ -193,111 +835,103 @@ bool TSP::LKH(const vector<int> &vids, const int &max_cost, vector<int> &soln_to
     }
   } else {
 
-    // generate temporary filenames
-    string tmp_dir;
-    if (getenv("TEMP")) tmp_dir = getenv("TEMP");
-    else                tmp_dir = "/tmp";
-    string parm_str_filename = tmp_dir + "/sattsp.par.XXXXXX";
-    string prob_str_filename = tmp_dir + "/sattsp.tsp.XXXXXX";
-    string soln_str_filename = tmp_dir + "/sattsp.soln.XXXXXX";
-    char* parm_filename = new char[parm_str_filename.size() + 1];
-    char* prob_filename = new char[prob_str_filename.size() + 1];
-    char* soln_filename = new char[soln_str_filename.size() + 1];
-    std::copy(parm_str_filename.begin(), parm_str_filename.end(), parm_filename);
-    std::copy(prob_str_filename.begin(), prob_str_filename.end(), prob_filename);
-    std::copy(soln_str_filename.begin(), soln_str_filename.end(), soln_filename);
-    parm_filename[parm_str_filename.size()] = '\0';
-    prob_filename[prob_str_filename.size()] = '\0';
-    soln_filename[soln_str_filename.size()] = '\0';
-    int parm_fd = mkstemp(parm_filename);
-    int prob_fd = mkstemp(prob_filename);
-    int soln_fd = mkstemp(soln_filename);
-    close (soln_fd);
-    close (parm_fd);
-    close (prob_fd);
-
-    // parameter file
-    ofstream parm_file;
-    parm_file.open(parm_filename, ios::trunc);
-    parm_file << "PROBLEM_FILE      = " << prob_filename << '\n';
-    parm_file << "TOUR_FILE         = " << soln_filename << '\n';
-    parm_file << get_lkh_parameters();
-    parm_file << "TIME_LIMIT        = 10\n";
-    parm_file << "STOP_AT_MAX_COST  = YES\n";
-    parm_file << "MAX_COST          = " << int(max_cost) << '\n';
-    parm_file << "SEED              = " << int(rand()) << '\n';
-    parm_file.close();
-
-    // problem file
-    ofstream prob_file;
-    prob_file.open(prob_filename, ios::trunc);
-    prob_file << "NAME:                solver03\n";
-    prob_file << "COMMENT:             solver03\n";
-    prob_file << "TYPE:                ATSP\n";
-    prob_file << "DIMENSION:           " << vids.size() << '\n';
-    prob_file << "EDGE_WEIGHT_TYPE:    EXPLICIT\n";
-    prob_file << "EDGE_WEIGHT_FORMAT:  FULL_MATRIX\n";
-    prob_file << '\n';
-    prob_file << "EDGE_WEIGHT_SECTION\n";
-    for (unsigned int i=0; i<sorted_vids.size(); i++) {
-      for (unsigned int j=0; j<sorted_vids.size(); j++) {
-        int vid00 = sorted_vids[i];
-        int vid01 = sorted_vids[j];
-        prob_file << int(edge_weight[vid00][vid01]) << " ";
-      }
-      prob_file << '\n';
+    // answer from previous calls on the same subset if possible
+    vector<int> seed(seeds);
+    {
+      lock_guard<mutex> lock(lkh_mutex);
+      bool feasible;
+      if (cache.lookup(sorted_vids, max_cost, soln_tour, soln_cost, feasible))
+        return feasible;
+      for (int k=0; k<seeds; k++)
+        seed[k] = rand();
     }
-    prob_file << "EOF\n";
-    prob_file.close();
-
-    // run LKH_cost
-    string cmd = "cbLKH " + string(parm_filename);
-
-    FILE* pipe = popen(cmd.c_str(), "r");
-    char buffer[128];
-    while (!feof(pipe)) {
-      if(fgets(buffer, 128, pipe) != NULL) {
-        string line(buffer);
-        boost::regex soln_rx ("Cost.min = \\d+");
-        if ( regex_search(line, soln_rx) ) {
-          boost::regex int_rx("\\d+");
-          boost::sregex_token_iterator token_itr (line.begin(), line.end(), int_rx, 0);
-          boost::sregex_token_iterator end;
-          soln_cost = atoi(string(*token_itr).c_str());
+
+    // warm start from the previous tour
+    int n = sorted_vids.size();
+    vector<int> initial;
+    if (initial_tour != NULL && initial_tour->size() > 0) {
+      vector<int> warm_tour;
+      vector<bool> covered(n, false);
+      for (int i=0; i<initial_tour->size(); i++) {
+        int k = lower_bound(sorted_vids.begin(), sorted_vids.end(), (*initial_tour)[i]) - sorted_vids.begin();
+        if (k < n && sorted_vids[k] == (*initial_tour)[i] && !covered[k]) {
+          covered[k] = true;
+          warm_tour.push_back(sorted_vids[k]);
         }
-		  }
+      }
+      for (int k=0; k<n; k++) {
+        if (!covered[k])
+          cheapest_insertion(warm_tour, sorted_vids[k]);
+      }
+      int warm_cost = cycle_cost(warm_tour);
+      if (warm_cost <= max_cost) {
+        soln_tour = warm_tour;
+        soln_cost = warm_cost;
+        lock_guard<mutex> lock(lkh_mutex);
+        cache.insert_tour(sorted_vids, soln_tour, soln_cost);
+        return true;
+      }
+      for (int i=0; i<n; i++) {
+        initial.push_back(lower_bound(sorted_vids.begin(), sorted_vids.end(), warm_tour[i]) - sorted_vids.begin());
+      }
     }
-    pclose(pipe);
 
-    // get tour
-    if (soln_cost <= max_cost) {
-      soln_tour.clear();
-      ifstream soln_file(soln_filename);
-      boost::regex int_rx("\\d+");
+    // parameters, without the seed
+    stringstream parameters;
+    parameters << get_lkh_parameters();
+    parameters << "TIME_LIMIT        = 10\n";
+    parameters << "STOP_AT_MAX_COST  = YES\n";
+    parameters << "MAX_COST          = " << int(max_cost) << '\n';
+
+    // cost matrix
+    vector<int> matrix(n*n);
+    for (int i=0; i<n; i++) {
+      for (int j=0; j<n; j++) {
+        matrix[i*n+j] = edge_weight(sorted_vids[i],sorted_vids[j]);
+      }
+    }
 
-      string line;
-      bool tour_section(false);
-      while (getline(soln_file, line)) {
+    // candidates of the whole instance, unless too few survive in the subset
+    vector<int> pi, candidates;
+    if (!restrict_candidates(sorted_vids, matrix, pi, candidates)) {
+      pi.clear();
+      candidates.clear();
+    }
 
-        if (line == "TOUR_SECTION")
-          tour_section = true;
-        
-        if (tour_section && regex_match(line, int_rx) )
-          soln_tour.push_back(sorted_vids[atoi(line.c_str())-1]);
+    // cbLKH reads the flags as plain ints with __atomic_load_n
+    static_assert(sizeof(atomic<int>) == sizeof(int), "atomic<int> is passed to cbLKH as int");
+
+    // run LKH in-process, one run per seed, the first within max_cost
+    // stops the rest
+    vector<vector<int>> tour(seeds, vector<int>(n));
+    vector<long long> cost(seeds, LLONG_MAX);
+    atomic<int> stop(0);
+    pool->run(seeds, [&](int k) {
+      if (stop || (cancel && *cancel))
+        return;
+      stringstream seed_parameters;
+      seed_parameters << parameters.str();
+      seed_parameters << "SEED              = " << seed[k] << '\n';
+      if (!LKH_SolveMatrix(seed_parameters.str().c_str(), n, &matrix[0], initial.size() > 0 ? &initial[0] : NULL, pi.size() > 0 ? &pi[0] : NULL, candidates.size() > 0 ? &candidates[0] : NULL, CANDIDATES_PER_NODE, &tour[k][0], &cost[k], (const int*) cancel, (const int*) &stop))
+        cost[k] = LLONG_MAX;
+      else if (cost[k] <= max_cost)
+        stop = 1;
+    });
+    int best = min_element(cost.begin(), cost.end()) - cost.begin();
+    if (cost[best] == LLONG_MAX)
+      return false;
+    soln_cost = cost[best];
 
-        if (tour_section && line == "-1\n")
-          tour_section = false;
-      }
-      soln_file.close();
-      remove(soln_filename);
+    // get tour, the best one even if none is within max_cost
+    soln_tour.clear();
+    for (int i=0; i<n; i++)
+      soln_tour.push_back(sorted_vids[tour[best][i]]);
+    lock_guard<mutex> lock(lkh_mutex);
+    if (soln_cost <= max_cost) {
+      cache.insert_tour(sorted_vids, soln_tour, soln_cost);
+    } else if (!cancel || !*cancel) {
+      cache.insert_infeasible(sorted_vids, max_cost);
     }
-
-    remove(parm_filename);
-    remove(prob_filename);
-    remove(soln_filename);
-    delete[] parm_filename;
-    delete[] prob_filename;
-    delete[] soln_filename;
   }
   return (soln_cost <= max_cost);
 }
@@ -305,11 +939,105 @@ bool TSP::LKH(const vector<int> &vids, const int &max_cost, vector<int> &soln_to
 
 
 
+/************************************************************//**
+ * @brief	Alpha candidates of the whole instance, computed once
+ * @version						v0.01b
+ * Called under lkh_mutex. The alpha values come from a plain 1-tree,
+ * an ascent over the whole instance costs far more than it saves.
+ * Instances above CANDIDATE_DIMENSION are left to each LKH call.
+ ****************************************************************/
+void TSP::create_candidates() {
+  _candidates = 0;
+  int n = size();
+  if (n < 4 || n > CANDIDATE_DIMENSION)
+    return;
+
+  stringstream parameters;
+  parameters << get_lkh_parameters();
+  parameters << "MAX_CANDIDATES    = " << CANDIDATES_PER_NODE << '\n';
+  parameters << "SUBGRADIENT       = NO\n";
+  parameters << "EXCESS            = 1\n";
+
+  vector<int> matrix(n*n);
+  for (int i=0; i<n; i++) {
+    for (int j=0; j<n; j++) {
+      matrix[i*n+j] = edge_weight(i,j);
+    }
+  }
+  candidate_pi.resize(2*n);
+  candidate_sets.resize(2*n*(2*CANDIDATES_PER_NODE+1));
+  if (LKH_CreateCandidates(parameters.str().c_str(), n, &matrix[0], CANDIDATES_PER_NODE, &candidate_pi[0], &candidate_sets[0]))
+    _candidates = 1;
+}
+
+
+/************************************************************//**
+ * @brief	Restrict the global candidates to a subset for LKH
+ * @version						v0.01b
+ * Nodes left with fewer than CANDIDATE_TOP_UP candidates are topped
+ * up with their nearest partners in matrix (the subset's cost matrix).
+ * Returns false if that is needed for most nodes, in which case LKH
+ * falls back to its own ascent.
+ ****************************************************************/
+bool TSP::restrict_candidates(const vector<int> &sorted_vids, const vector<int> &matrix, vector<int> &pi, vector<int> &candidates) {
+  {
+    lock_guard<mutex> lock(lkh_mutex);
+    if (_candidates < 0)
+      create_candidates();
+  }
+  if (_candidates == 0)
+    return false;
+
+  int n(size()), m(sorted_vids.size()), stride(2*CANDIDATES_PER_NODE+1), short_nodes(0);
+  int top_up = min(m, CANDIDATE_TOP_UP);
+  vector<bool> listed(m);
+  vector<pair<int,int>> nearest;
+  pi.resize(2*m);
+  candidates.assign(2*m*stride, 0);
+  for (int k=0; k<2*m; k++) {
+    int node = k < m ? sorted_vids[k] : sorted_vids[k-m] + n;
+    const int *from = &candidate_sets[node*stride];
+    int *to = &candidates[k*stride];
+    pi[k] = candidate_pi[node];
+    fill(listed.begin(), listed.end(), false);
+    for (int c=0; c<from[0]; c++) {
+      int global = from[2*c+1] - 1;
+      int l = lower_bound(sorted_vids.begin(), sorted_vids.end(), global % n) - sorted_vids.begin();
+      if (l < m && sorted_vids[l] == global % n) {
+        to[2*to[0]+1] = l + 1 + (global < n ? 0 : m);
+        to[2*to[0]+2] = from[2*c+2];
+        to[0]++;
+        listed[l] = true;
+      }
+    }
+    if (to[0] >= top_up)
+      continue;
+
+    // nodes of one side only neighbour the other side, row k or column k-m
+    if (++short_nodes > m && m > CANDIDATE_TOP_UP)
+      return false;
+    nearest.clear();
+    for (int l=0; l<m; l++) {
+      if (!listed[l])
+        nearest.push_back(make_pair(k < m ? matrix[k*m+l] : matrix[l*m+k-m], l));
+    }
+    int needed = min(top_up - to[0], (int) nearest.size());
+    partial_sort(nearest.begin(), nearest.begin()+needed, nearest.end());
+    for (int i=0; i<needed; i++) {
+      to[2*to[0]+1] = nearest[i].second + 1 + (k < m ? m : 0);
+      to[2*to[0]+2] = INT_MAX-1;
+      to[0]++;
+    }
+  }
+  return true;
+}
+
+
 /************************************************************//**
  * @brief	
  * @version						v0.01b
  ****************************************************************/
-bool TSP::solve(const vector<int> &vids, const int tsp_cost_budget, const int subgraph_cost_budget, vector<int> &soln_tour, int &soln_cost) {
+bool TSP::solve(const vector<int> &vids, const int tsp_cost_budget, const int subgraph_cost_budget, vector<int> &soln_tour, int &soln_cost, const vector<int> *initial_tour) {
 
   // seperate vids into subgraph_vids
   int i(0), j(0), x, y, z;
@@ -335,16 +1063,26 @@ bool TSP::solve(const vector<int> &vids, const int tsp_cost_budget, const int su
       cout << "  subgraph_cost_budget = " << subgraph_cost_budget << '\n';
   #endif
 
-  // solve each subgraph
+  // warm start each subgraph from its part of initial_tour
+  vector<vector<int>> initial_subtours(subgraphs.size());
+  if (initial_tour != NULL)
+      split_vids(*initial_tour, initial_subtours);
+
+  // solve each subgraph in parallel, the first failure cancels the rest
   int tsp_cost(0);
   vector<int> subgraph_cost(subgraphs.size());
   vector<vector<int>> subgraph_tour(subgraphs.size());
+  atomic<int> cancel(0);
+  pool->run(subgraphs.size(), [&](int i) {
+      if (cancel)
+          return;
+      if (!LKH(subgraph_vids[i], subgraph_cost_budget, subgraph_tour[i], subgraph_cost[i], &cancel, &initial_subtours[i]))
+          cancel = 1;
+  });
+  if (cancel)
+      return false;
   for (int i=0; i<subgraphs.size(); i++) {
-      if (LKH(subgraph_vids[i], subgraph_cost_budget, subgraph_tour[i], subgraph_cost[i])) {
-          tsp_cost += subgraph_cost[i];
-      } else {
-          return false;
-      }
+      tsp_cost += subgraph_cost[i];
   }
   
   #ifdef DEBUG
@@ -359,40 +1097,40 @@ bool TSP::solve(const vector<int> &vids, const int tsp_cost_budget, const int su
       }
   #endif
 
-  // re-solve until within tsp_cost_budget budget
-  i = j = 0;
-  vector<bool> subgraph_minimized(subgraphs.size());
+  // re-solve until within tsp_cost_budget budget, tightening every
+  // subgraph that may still improve in parallel
+  mutex cost_mutex;
+  vector<char> subgraph_minimized(subgraphs.size());
   for (int i=0; i<subgraphs.size(); i++) {
-      if (subgraph_vids[i].size() <= 3) {
-          subgraph_minimized[i] = true;
-      } else {
-          subgraph_minimized[i] = false;
-      }
+      subgraph_minimized[i] = (subgraph_vids[i].size() <= 3);
   }
   while (tsp_cost > tsp_cost_budget) {
-      if (!subgraph_minimized[i]) {
-          int cost;
+      vector<int> active;
+      for (int i=0; i<subgraphs.size(); i++) {
+          if (!subgraph_minimized[i])
+              active.push_back(i);
+      }
+      if (active.size() == 0) {
+          return false; // every subgraph is as short as LKH can make it
+      }
+      pool->run(active.size(), [&](int k) {
+          int i(active[k]), cost;
           vector<int> tour;
           int test_min, test_cost, test_max(subgraph_cost[i]-1);
-          test_min = subgraph_cost[i] - (tsp_cost-tsp_cost_budget);
+          {
+              lock_guard<mutex> lock(cost_mutex);
+              if (tsp_cost <= tsp_cost_budget)
+                  return;
+              test_min = subgraph_cost[i] - (tsp_cost-tsp_cost_budget);
+          }
           test_cost = test_min + floor((test_max-test_min)/2);
           while(true) {
-              if (LKH(subgraph_vids[i], test_cost, tour, cost)) {
+              if (LKH(subgraph_vids[i], test_cost, tour, cost, NULL, &subgraph_tour[i])) {
+                  lock_guard<mutex> lock(cost_mutex);
                   tsp_cost -= subgraph_cost[i];
                   subgraph_cost[i] = cost;
                   subgraph_tour[i] = tour;
                   tsp_cost += subgraph_cost[i];
-                  j = i; // keep track of last tsp solved
-                  #ifdef DEBUG
-                      cout << "  solved:\n";
-                      cout << "    cost = " << cost << '\n';
-                      cout << "    test_cost = " << test_cost << '\n';
-                      if (feasible(tour, test_cost, test_cost)) {
-                          cout << "    feasible\n";
-                      } else {
-                          cout << "    not feasible\n";
-                      }
-                  #endif
                   break;
               } else {
                   test_min = test_cost+1;
@@ -408,12 +1146,7 @@ bool TSP::solve(const vector<int> &vids, const int tsp_cost_budget, const int su
                   cout << "  test_max  = " << test_max << '\n';
               #endif
           }
-      } else {
-          i = (i+1) % subgraphs.size();
-          if (i == j) {
-              return false; // if we get back to the last one solved and still no soln, then quit
-          }
-      }
+      });
   }
   
   // concatenate solution
@@ -426,28 +1159,211 @@ bool TSP::solve(const vector<int> &vids, const int tsp_cost_budget, const int su
   } else {
       soln_cost = tsp_cost;
   }
-  soln_tour.clear();
-  for (int i=0; i<subgraphs.size(); i++) {
-      soln_tour.insert(soln_tour.end(), subgraph_tour[i].begin(), subgraph_tour[i].end());
+  soln_tour.clear();
+  for (int i=0; i<subgraphs.size(); i++) {
+      soln_tour.insert(soln_tour.end(), subgraph_tour[i].begin(), subgraph_tour[i].end());
+  }
+  
+  #ifdef DEBUG
+      for (int i=0; i < subgraphs.size(); i++) {
+          cout << "finial_subgraph_solns[" << i << "]: \n";
+          cout << "  cost = " << subgraph_cost[i] << '\n';
+          cout << "  tour =";
+          for (int j=0; j < subgraph_tour[i].size(); j++) {
+              cout << " " << subgraph_tour[i][j];
+          }
+          cout << '\n';
+      }
+      cout << "tsp cost = " << soln_cost << '\n';
+  #endif
+
+  return true;
+}
+
+
+
+
+/************************************************************//**
+ * @brief	Extend a feasible tour with vids without calling LKH
+ * @version						v0.01b
+ * Each vid is inserted at its cheapest position in its subgraph's
+ * tour, and the touched subgraph tours are then improved with
+ * Or-opt (and 2-opt if symmetric). Returns true if the result is
+ * within budget.
+ ****************************************************************/
+bool TSP::extend(const vector<int> &tour, const vector<int> &vids, const int tsp_cost_budget, const int subgraph_cost_budget, vector<int> &soln_tour) {
+
+  vector<vector<int>> sub_tours;
+  split_vids(tour, sub_tours);
+
+  vector<bool> touched(subgraphs.size(), false);
+  for (int i=0; i<vids.size(); i++) {
+      int j(0);
+      while (!std::binary_search(subgraphs[j].begin(), subgraphs[j].end(), vids[i]))
+          j++;
+      cheapest_insertion(sub_tours[j], vids[i]);
+      touched[j] = true;
+  }
+
+  soln_tour.clear();
+  for (int i=0; i<subgraphs.size(); i++) {
+      if (touched[i])
+          local_search(sub_tours[i]);
+      soln_tour.insert(soln_tour.end(), sub_tours[i].begin(), sub_tours[i].end());
+  }
+
+  #ifdef DEBUG
+      cout << "TSP::extend():\n";
+      cout << "  tour =";
+      for (int i=0; i < soln_tour.size(); i++) {
+          cout << " " << soln_tour[i];
+      }
+      cout << '\n';
+  #endif
+
+  return feasible(soln_tour, tsp_cost_budget, subgraph_cost_budget);
+}
+
+
+/************************************************************//**
+ * @brief	
+ * @version						v0.01b
+ ****************************************************************/
+int TSP::cycle_cost(const vector<int> &tour) {
+  int cost(0);
+  for (int i=0; i<tour.size(); i++)
+    cost += edge_weight(tour[i],tour[(i+1)%tour.size()]);
+  return cost;
+}
+
+
+/************************************************************//**
+ * @brief	Insert vid where it increases the tour cost the least
+ * @version						v0.01b
+ ****************************************************************/
+void TSP::cheapest_insertion(vector<int> &tour, const int vid) {
+  if (tour.size() < 2) {
+    tour.push_back(vid);
+    return;
+  }
+
+  int best_pos(0), best_delta(INF);
+  for (int i=0; i<tour.size(); i++) {
+    int x(tour[i]), y(tour[(i+1)%tour.size()]);
+    int delta = edge_weight(x,vid) + edge_weight(vid,y) - edge_weight(x,y);
+    if (delta < best_delta) {
+      best_delta = delta;
+      best_pos = i+1;
+    }
   }
-  
-  #ifdef DEBUG
-      for (int i=0; i < subgraphs.size(); i++) {
-          cout << "finial_subgraph_solns[" << i << "]: \n";
-          cout << "  cost = " << subgraph_cost[i] << '\n';
-          cout << "  tour =";
-          for (int j=0; j < subgraph_tour[i].size(); j++) {
-              cout << " " << subgraph_tour[i][j];
+  tour.insert(tour.begin()+best_pos, vid);
+}
+
+
+/************************************************************//**
+ * @brief	First-improvement Or-opt and (symmetric only) 2-opt
+ * @version						v0.01b
+ * Or-opt moves segments of up to three vertices to another edge
+ * without reversing them, so it is safe for asymmetric weights.
+ ****************************************************************/
+void TSP::local_search(vector<int> &tour) {
+  int n = tour.size();
+  if (n < 5)
+    return;
+
+  bool improved(true);
+  while (improved) {
+    improved = false;
+
+    // 2-opt: replace (a,b),(c,d) with (a,c),(b,d) and reverse b..c
+    if (symmetric()) {
+      for (int i=0; i<n-1 && !improved; i++) {
+        for (int j=i+2; j<n && !improved; j++) {
+          int a(tour[i]), b(tour[i+1]), c(tour[j]), d(tour[(j+1)%n]);
+          if (a == d)
+            continue;
+          if (edge_weight(a,c) + edge_weight(b,d) < edge_weight(a,b) + edge_weight(c,d)) {
+            reverse(tour.begin()+i+1, tour.begin()+j+1);
+            improved = true;
           }
-          cout << '\n';
+        }
       }
-      cout << "tsp cost = " << soln_cost << '\n';
-  #endif
+    }
 
-  return true;
+    // Or-opt: move tour[i..i+len) between tour[j] and tour[j+1]
+    for (int len=1; len<=3 && !improved; len++) {
+      for (int i=0; i<n && !improved; i++) {
+        int first(tour[i]), last(tour[(i+len-1)%n]);
+        int prev(tour[(i+n-1)%n]), next(tour[(i+len)%n]);
+        int removed = edge_weight(prev,first) + edge_weight(last,next) - edge_weight(prev,next);
+        for (int k=len; k<n-1 && !improved; k++) {
+          int x(tour[(i+k)%n]), y(tour[(i+k+1)%n]);
+          if (edge_weight(x,first) + edge_weight(last,y) - edge_weight(x,y) < removed) {
+            vector<int> segment, rest;
+            for (int m=0; m<len; m++)
+              segment.push_back(tour[(i+m)%n]);
+            for (int m=len; m<n; m++) {
+              rest.push_back(tour[(i+m)%n]);
+              if (m == k)
+                rest.insert(rest.end(), segment.begin(), segment.end());
+            }
+            tour = rest;
+            improved = true;
+          }
+        }
+      }
+    }
+  }
 }
 
 
+/************************************************************//**
+ * @brief	1-tree lower bound on any tour through vids
+ * @version						v0.01b
+ * Spanning tree of vids[1..k) plus the two cheapest edges of vids[0],
+ * only a bound on symmetric instances. Dense Prim over the subset, so
+ * the scratch is O(k) rather than graph sized.
+ ****************************************************************/
+int TSP::one_tree_bound(const vector<int> &vids) {
+  int k = vids.size();
+  if (k < 2)
+    return 0;
+  if (k == 2)
+    return edge_weight(vids[0],vids[1]) + edge_weight(vids[1],vids[0]);
+
+  // order[1..size) are the vertices not yet in the tree
+  vector<int> key(k, INT32_MAX), order(vids);
+  int size = k-1;
+  int last = order[size];
+  int tree = 0;
+  while (size > 1) {
+    int best = 1;
+    for (int i=1; i<size; i++) {
+      int w = edge_weight(last,order[i]);
+      if (w < key[i])
+        key[i] = w;
+      if (key[i] < key[best])
+        best = i;
+    }
+    tree += key[best];
+    last = order[best];
+    size--;
+    std::swap(order[best], order[size]);
+    std::swap(key[best], key[size]);
+  }
+
+  int first(INT32_MAX), second(INT32_MAX);
+  for (int i=1; i<k; i++) {
+    int w = edge_weight(vids[0],vids[i]);
+    if (w < first) {
+      second = first;
+      first  = w;
+    } else if (w < second) {
+      second = w;
+    }
+  }
+  return tree + first + second;
+}
 
 
 /************************************************************//**
@@ -461,150 +1377,154 @@ int parse_input(string filename, TSP &graph) {
   graph.adjacency.clear();
   graph.edge_weight.clear();
 
-  // open file
-  ifstream file;
-  try {
-    file.open(filename.c_str());
-  } catch(exception& e) {
-    cerr << "error: " << e.what() << "\n";
+  // map file
+  int fd = open(filename.c_str(), O_RDONLY);
+  struct stat file_stat;
+  if (fd < 0 || fstat(fd, &file_stat) != 0 || file_stat.st_size == 0) {
+    cerr << "error: could not read " << filename << "\n";
+    if (fd >= 0)
+      close(fd);
     return 1;
-  } catch(...) {
-    cerr << "Exception of unknown type!\n";
   }
-  
+  size_t length = file_stat.st_size;
+  void *mapping = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    cerr << "error: could not map " << filename << "\n";
+    return 1;
+  }
+  madvise(mapping, length, MADV_SEQUENTIAL);
+  const char *text = (const char*) mapping;
+  const char *text_end = text + length;
+
+  // FNV-1a of the file, keys the sidecar property cache
+  graph.filename = filename;
+  graph.file_hash = 14695981039346656037ULL;
+  for (const char *c = text; c < text_end; c++)
+    graph.file_hash = (graph.file_hash ^ (unsigned char) *c) * 1099511628211ULL;
   
   // helper structures
   string parse_state = "HEADER";
   string data_type = "";
-  int vid00(0), vid01(0), subgraph_index(0), gtsp_set_index(0);
+  string value;
+  int vid00(0), vid01(0), subgraph_index(0), gtsp_set_index(0), dimension(0);
   vector<vector<double>> coords;
-  while (file.good()) {
-    string line;
-    getline(file, line);
-//    cout << line << '\n';
+  vector<int> data;
+  for (const char *line = text; line < text_end; ) {
+    const char *end = (const char*) memchr(line, '\n', text_end-line);
+    if (end == NULL)
+      end = text_end;
+    const char *p = skip_space(line, end);
 
     // setup
     if (parse_state == "HEADER") {
     
       // name
-      boost::regex name_rx ("^\\s*NAME\\s*:?\\s*[\\w_]+\\s*$");
-      if ( regex_match(line, name_rx) ) {
-        graph.name = get_token(line);
+      if (parse_keyword(p, end, "NAME", value)) {
+        graph.name = value;
       }
 
       // type
-      boost::regex problem_type_rx ("^\\s*TYPE\\s*:?\\s*[\\w_]+\\s*$");
-      if ( regex_match(line, problem_type_rx) ) {
-        graph.type = get_token(line);
+      if (parse_keyword(p, end, "TYPE", value)) {
+        graph.type = value;
       }
 
       // dimension
-      boost::regex size_rx ("^\\s*DIMENSION\\s*:?\\s*\\d+\\s*$");
-      if ( regex_match(line, size_rx) ) {
-        int size = atoi(get_token(line).c_str());
-        for (int i=0; i<size; i++) {
-          graph.adjacency.push_back(vector<bool>());
-          graph.edge_weight.push_back(vector<int>());
-          for (int j=0; j<size; j++) {
-            graph.adjacency[i].push_back(false);
-            graph.edge_weight[i].push_back(-1);
-          }
-        }
+      if (parse_keyword(p, end, "DIMENSION", value)) {
+        dimension = atoi(value.c_str());
       }
 
       // max tsp cost
-      boost::regex tsp_cost_budget_rx ("^\\s*MAX_TSP_COST\\s*:?\\s*\\d+\\s*$");
-      if ( regex_match(line, tsp_cost_budget_rx) ) {
-        int cost = atoi(get_token(line).c_str());
-        graph.tsp_cost_budget = cost;
+      if (parse_keyword(p, end, "MAX_TSP_COST", value)) {
+        graph.tsp_cost_budget = atoi(value.c_str());
       }
 
       // max subgraph cost
-      boost::regex subgraph_cost_budget_rx ("^\\s*MAX_SUBGRAPH_COST\\s*:?\\s*\\d+\\s*$");
-      if ( regex_match(line, subgraph_cost_budget_rx) ) {
-        int cost = atoi(get_token(line).c_str());
-        graph.subgraph_cost_budget = cost;
+      if (parse_keyword(p, end, "MAX_SUBGRAPH_COST", value)) {
+        graph.subgraph_cost_budget = atoi(value.c_str());
       }
       
       // edge weight type
-      boost::regex edge_weight_type_rx ("^\\s*EDGE_WEIGHT_TYPE\\s*:?\\s*[\\w_]+\\s*$");
-      if ( regex_match(line, edge_weight_type_rx) ) {
-        data_type = get_token(line);
+      if (parse_keyword(p, end, "EDGE_WEIGHT_TYPE", value)) {
+        data_type = value;
       }
       
       // edge weight format
-      boost::regex edge_weight_format_rx ("^\\s*EDGE_WEIGHT_FORMAT\\s*:?\\s*[\\w_]+\\s*$");
-      if (regex_search(line, edge_weight_format_rx) && data_type == "EXPLICIT") {
-        data_type = get_token(line);
+      if (parse_keyword(p, end, "EDGE_WEIGHT_FORMAT", value) && data_type == "EXPLICIT") {
+        data_type = value;
       }
 
     // parse matrix
     } else if (parse_state == "MATRIX_DATA") {
     
-      boost::regex matrix_row_rx ("^\\s*\\d+");
-      if ( regex_search(line, matrix_row_rx) ) {
-        boost::regex int_rx("\\d+");
-        boost::sregex_token_iterator token_itr (line.begin(), line.end(), int_rx, 0);
-        boost::sregex_token_iterator end;
-        while (token_itr != end) {
-          int weight = atoi(string(*token_itr).c_str());
-          token_itr++;
+      if (p < end && is_digit(*p)) {
+        bool full_matrix(data_type == "FULL_MATRIX"), lower_row(data_type == "LOWER_ROW");
+        bool lower_diag_row(data_type == "LOWER_DIAG_ROW"), upper_row(data_type == "UPPER_ROW");
+        bool upper_diag_row(data_type == "UPPER_DIAG_ROW");
+        while (true) {
+          while (p < end && !is_digit(*p))
+            p++;
+          if (p == end)
+            break;
+          int weight(0);
+          while (p < end && is_digit(*p))
+            weight = 10*weight + (*p++ - '0');
           // tested: 16.12.02
-          if (data_type == "FULL_MATRIX") {
-            graph.adjacency[vid00][vid01]   = (weight < INF);
-            graph.edge_weight[vid00][vid01] = weight;
+          if (full_matrix) {
+            graph.adjacency.set(vid00, vid01, (weight < INF));
+            graph.edge_weight.set(vid00, vid01, weight);
             vid01++;
             if (vid01 >= graph.size()) {
               vid00++;
               vid01 = 0;
             }
           // not tested:
-          } else if (data_type == "LOWER_ROW") {
+          } else if (lower_row) {
             cerr << "WARNING: LOWER_ROW has not been tested! \n";
             if (vid00 == 0 && vid01 == 0) {
                 vid00 = 1;
             }
-            graph.adjacency[vid00][vid01]   = (weight < INF);
-            graph.adjacency[vid01][vid00]   = (weight < INF);
-            graph.edge_weight[vid00][vid01] = weight;
-            graph.edge_weight[vid01][vid00] = weight;
+            graph.adjacency.set(vid00, vid01, (weight < INF));
+            graph.adjacency.set(vid01, vid00, (weight < INF));
+            graph.edge_weight.set(vid00, vid01, weight);
+            graph.edge_weight.set(vid01, vid00, weight);
             vid01++;
             if (vid01 >= vid00) {
               vid00++;
               vid01 = 0;
             }
           // tested: 16.12.02
-          } else if (data_type == "LOWER_DIAG_ROW") {
-            graph.adjacency[vid00][vid01]   = (weight < INF);
-            graph.adjacency[vid01][vid00]   = (weight < INF);
-            graph.edge_weight[vid00][vid01] = weight;
-            graph.edge_weight[vid01][vid00] = weight;
+          } else if (lower_diag_row) {
+            graph.adjacency.set(vid00, vid01, (weight < INF));
+            graph.adjacency.set(vid01, vid00, (weight < INF));
+            graph.edge_weight.set(vid00, vid01, weight);
+            graph.edge_weight.set(vid01, vid00, weight);
             vid01++;
             if (vid01 > vid00) {
               vid00++;
               vid01 = 0;
             }
           // tested: 16.12.02
-          } else if (data_type == "UPPER_ROW") {
+          } else if (upper_row) {
             if (vid00 == 0 && vid01 == 0) {
                 vid01 = 1;
             }
-            graph.adjacency[vid00][vid01]   = (weight < INF);
-            graph.adjacency[vid01][vid00]   = (weight < INF);
-            graph.edge_weight[vid00][vid01] = weight;
-            graph.edge_weight[vid01][vid00] = weight;
+            graph.adjacency.set(vid00, vid01, (weight < INF));
+            graph.adjacency.set(vid01, vid00, (weight < INF));
+            graph.edge_weight.set(vid00, vid01, weight);
+            graph.edge_weight.set(vid01, vid00, weight);
             vid01++;
             if (vid01 >= graph.size()) {
               vid00++;
               vid01 = vid00+1;
             }
           // not working: 16.12.02
-          } else if (data_type == "UPPER_DIAG_ROW") {
+          } else if (upper_diag_row) {
             cerr << "WARNING: UPPER_DIAG_ROW has not been tested! \n";
-            graph.adjacency[vid00][vid01]   = (weight < INF);
-            graph.adjacency[vid01][vid00]   = (weight < INF);
-            graph.edge_weight[vid00][vid01] = weight;
-            graph.edge_weight[vid01][vid00] = weight;
+            graph.adjacency.set(vid00, vid01, (weight < INF));
+            graph.adjacency.set(vid01, vid00, (weight < INF));
+            graph.edge_weight.set(vid00, vid01, weight);
+            graph.edge_weight.set(vid01, vid00, weight);
             vid01++;            
             if (vid01 >= graph.size()) {
               vid00++;
@@ -612,79 +1532,55 @@ int parse_input(string filename, TSP &graph) {
             }
           } else {
             cerr << "error: invalid parsing state\n";
+            munmap(mapping, length);
             return 1;
           }
         }
       }
     
-    // parse coordinates
+    // parse coordinates: index x y
     } else if (parse_state == "COORD_DATA") {
-      boost::regex float_coordinate_rx ("^\\s*\\d+\\s+-?\\d+\\.\\d+\\s+-?\\d+\\.\\d+");
-      boost::regex int_coordinate_rx ("^\\s*\\d+\\s+-?\\d+\\s+-?\\d+");
-      vector<double> coord;
-      
-      if ( regex_search(line, float_coordinate_rx) ) {
-        boost::regex double_rx("-?\\d+\\.\\d+");
-        boost::sregex_token_iterator token_itr (line.begin(), line.end(), double_rx, 0);
-        coord.push_back(atof(string(*token_itr).c_str()));
-        token_itr++;
-        coord.push_back(atof(string(*token_itr).c_str()));
-        coords.push_back(coord);
-      } else if ( regex_search(line, int_coordinate_rx) ) {
-        boost::regex int_rx("-?\\d+");
-        boost::sregex_token_iterator token_itr (line.begin(), line.end(), int_rx, 0);
-        token_itr++;
-        coord.push_back(atoi(string(*token_itr).c_str()));
-        token_itr++;
-        coord.push_back(atoi(string(*token_itr).c_str()));
+      int index;
+      double x, y;
+      const char *q = p;
+      if (parse_int(q, end, index) && parse_double(q, end, x) && parse_double(q, end, y)) {
+        vector<double> coord;
+        coord.push_back(x);
+        coord.push_back(y);
         coords.push_back(coord);
       }
 
     // parse subgraph data
     } else if (parse_state == "SUBGRAPH_DATA") {
-      boost::regex data_rx ("^\\s*\\d+\\s+-?\\d+\\s+-?\\d+");
-      if ( regex_search(line, data_rx) ) {
-        int data(-1);
-        boost::regex int_rx("-?\\d+");
-        boost::sregex_token_iterator token_itr (line.begin(), line.end(), int_rx, 0);
-        data = atoi(string(*token_itr).c_str());
-        if (data == subgraph_index+1) {
+      if (parse_ints(p, end, data) >= 3 && data[0] >= 0) {
+        int i(0);
+        if (data[0] == subgraph_index+1) {
           graph.subgraphs.push_back(vector<int>());
-          token_itr++;
+          i++;
         }
-        boost::sregex_token_iterator end;
-        while (token_itr != end) {
-          data = atoi(string(*token_itr).c_str());
-          token_itr++;
-          if (data == -1) {
+        for (; i<data.size(); i++) {
+          if (data[i] == -1) {
             sort(graph.subgraphs[subgraph_index].begin(), graph.subgraphs[subgraph_index].end());
             subgraph_index++;
           } else {
-            graph.subgraphs[subgraph_index].push_back(data-1);
+            graph.subgraphs[subgraph_index].push_back(data[i]-1);
           }
         }
       }
 
     // parse GTSP data
     } else if (parse_state == "GTSP_DATA") {
-      boost::regex data_rx ("^\\s*\\d+\\s+-?\\d+\\s+-?\\d+");
-      if ( regex_search(line, data_rx) ) {
-        int data(-1);
-        boost::regex int_rx("-?\\d+");
-        boost::sregex_token_iterator token_itr (line.begin(), line.end(), int_rx, 0);
-        data = atoi(string(*token_itr).c_str());
-        if (data == gtsp_set_index+1) {
+      if (parse_ints(p, end, data) >= 3 && data[0] >= 0) {
+        int i(0);
+        if (data[0] == gtsp_set_index+1) {
           graph.gtsp_sets.push_back(vector<int>());
-          token_itr++;
+          i++;
         }
-        boost::sregex_token_iterator end;
-        while (token_itr != end) {
-          data = atoi(string(*token_itr).c_str());
-          token_itr++;
-          if (data == -1) {
+        for (; i<data.size(); i++) {
+          if (data[i] == -1) {
             gtsp_set_index++;
           } else {
-            graph.gtsp_sets[gtsp_set_index].push_back(data-1);
+            graph.gtsp_sets[gtsp_set_index].push_back(data[i]-1);
           }
         }
       }
@@ -692,125 +1588,54 @@ int parse_input(string filename, TSP &graph) {
 
     
     // transitions
-    boost::regex edge_data_rx ("^\\s*EDGE_WEIGHT_SECTION\\s*:?\\s*$");
-    if ( regex_match(line, edge_data_rx) ) {
-      parse_state = "MATRIX_DATA";
-    }
-    boost::regex coord_data_rx ("^\\s*NODE_COORD_SECTION\\s*:?\\s*$");
-    if ( regex_match(line, coord_data_rx) ) {
-      parse_state = "COORD_DATA";
-    }
-    boost::regex subgraph_rx ("^\\s*SUBGRAPH_SECTION\\s*:?\\s*$");
-    if ( regex_match(line, subgraph_rx) ) {
-      parse_state = "SUBGRAPH_DATA";
-    }
-    boost::regex gtsp_rx ("^\\s*GTSP_SET_SECTION\\s*:?\\s*$");
-    if ( regex_match(line, gtsp_rx) ) {
-      parse_state = "GTSP_DATA";
-    }
-    boost::regex display_rx ("^\\s*DISPLAY_DATA_SECTION\\s*:?\\s*$");
-    if ( regex_match(line, display_rx) ) {
-      parse_state = "DISPLAY_DATA";
+    if (p < end && !is_digit(*p) && *p != '-') {
+      if (parse_section(p, end, "EDGE_WEIGHT_SECTION")) {
+        parse_state = "MATRIX_DATA";
+        graph.adjacency.resize(dimension);
+        graph.edge_weight.resize(dimension, -1);
+      } else if (parse_section(p, end, "NODE_COORD_SECTION")) {
+        parse_state = "COORD_DATA";
+      } else if (parse_section(p, end, "SUBGRAPH_SECTION")) {
+        parse_state = "SUBGRAPH_DATA";
+      } else if (parse_section(p, end, "GTSP_SET_SECTION")) {
+        parse_state = "GTSP_DATA";
+      } else if (parse_section(p, end, "DISPLAY_DATA_SECTION")) {
+        parse_state = "DISPLAY_DATA";
+      }
     }
 
+    line = end+1;
   }
+  munmap(mapping, length);
 
-  // convert coord data to matrix
-  // tested: 16.12.02
+  // coordinate instances keep only the coordinates, small ones are
+  // materialized since table lookups are cheaper than recomputing
+  // tested: 16.12.02 (EUC_2D, GEO, ATT)
+  int kind = WEIGHT_EXPLICIT;
   if (data_type == "EUC_2D") {
-    for (int vid00=0; vid00 < graph.size(); vid00++) {
-      for (int vid01=0; vid01 < graph.size(); vid01++) {
-        if (vid00 == vid01) {
-          graph.adjacency[vid00][vid01]   = false;
-          graph.edge_weight[vid00][vid01] = INF;
-        } else {
-          double dx = coords[vid00][0] - coords[vid01][0];
-          double dy = coords[vid00][1] - coords[vid01][1];
-          double weight = sqrt(pow(dx,2) + pow(dy,2));
-          graph.adjacency[vid00][vid01]   = true;
-          graph.edge_weight[vid00][vid01] = nint(weight);
-        }        
-      }
-    }
-  // tested: 16.12.02
+    kind = WEIGHT_EUC_2D;
   } else if (data_type == "GEO") {
-    double RRR = 6378.388;
-    double PI = 3.141592;                
-    double deg(0), min(0);
-    for (int vid00=0; vid00 < graph.size(); vid00++) {
-      extract_deg_min(coords[vid00][0], deg, min);
-      double lat00 = PI * (deg + 5.0 * min / 3.0) / 180.0;
-      extract_deg_min(coords[vid00][1], deg, min);
-      double long00 = PI * (deg + 5.0 * min / 3.0) / 180.0;     
-      for (int vid01=0; vid01 < graph.size(); vid01++) {
-        extract_deg_min(coords[vid01][0], deg, min);
-        double lat01 = PI * (deg + 5.0 * min / 3.0) / 180.0;
-        extract_deg_min(coords[vid01][1], deg, min);
-        double long01 = PI * (deg + 5.0 * min / 3.0) / 180.0;     
-        if (vid00 == vid01) {
-          graph.adjacency[vid00][vid01]   = false;
-          graph.edge_weight[vid00][vid01] = INF;
-        } else {
-          double q1 = cos(long00 - long01);
-          double q2 = cos(lat00 - lat01);
-          double q3 = cos(lat00 + lat01);
-          double weight = RRR * acos(0.5*((1.0+q1)*q2 - (1.0-q1)*q3) ) + 1.0;
-          graph.adjacency[vid00][vid01]   = true;
-          graph.edge_weight[vid00][vid01] = int(weight);
-
-          #ifdef DEBUG96
-            cout << "coord[" << vid00 << "] = (" << coords[vid00][0] << "," << coords[vid00][1] << "), ";
-            cout << "coord[" << vid01 << "] = (" << coords[vid01][0] << "," << coords[vid01][1] << ")\n";
-            cout << "lat00 = " << lat00 << ", long00 = " << long00 << ", lat01 = " << lat01 << ", long01 = " << long01 << '\n';
-            cout << "q1 = " << q1 << ", q2 = " << q2 << ", q3 = " << q3 << ", weight = " << weight << '\n';
-          #endif          
-        }          
-      }
-    }
-  // tested: 16.12.02
+    kind = WEIGHT_GEO;
   } else if (data_type == "ATT") {
-    for (int vid00=0; vid00 < graph.size(); vid00++) {
-      for (int vid01=0; vid01 < graph.size(); vid01++) {
-        if (vid00 == vid01) {
-          graph.adjacency[vid00][vid01]   = false;
-          graph.edge_weight[vid00][vid01] = INF;
-        } else {
-          double dx = coords[vid00][0] - coords[vid01][0];
-          double dy = coords[vid00][1] - coords[vid01][1];
-          double r = sqrt(dx*dx/10.0 + dy*dy/10.0);
-          int weight = nint(r);
-          if (weight < r) {
-            weight++;
-          }
-          graph.adjacency[vid00][vid01]   = true;
-          graph.edge_weight[vid00][vid01] = weight;
-          #ifdef DEBUG96
-            cout << "coord: " << coords[vid00][0] << "," << coords[vid00][1] << '\n';
-            cout << "coord: " << coords[vid01][0] << "," << coords[vid01][1] << '\n';
-            cout << "weight: " << weight << '\n';
-          #endif          
-        }
-      }      
-    }
-  // not tested
+    kind = WEIGHT_ATT;
   } else if (data_type == "CEIL_2D") {
     cerr << "WARNING: CEIL_2D has not been tested! \n";
-    for (int vid00=0; vid00 < graph.size(); vid00++) {
-      for (int vid01=0; vid01 < graph.size(); vid01++) {
-        if (vid00 == vid01) {
-          graph.adjacency[vid00][vid01]   = false;
-          graph.edge_weight[vid00][vid01] = INF;
-        } else {
-          double dx = coords[vid00][0] - coords[vid01][0];
-          double dy = coords[vid00][1] - coords[vid01][1];
-          double weight = sqrt(pow(dx,2) + pow(dy,2));
-          graph.adjacency[vid00][vid01]   = true;
-          graph.edge_weight[vid00][vid01] = ceil(weight);
-        }
-      }
-    }
+    kind = WEIGHT_CEIL_2D;
+  }
+  if (kind != WEIGHT_EXPLICIT) {
+    coords.resize(dimension, vector<double>(2, 0.0));
+    graph.adjacency.complete(dimension);
+    graph.edge_weight.set_coordinates(kind, coords);
+    if (dimension <= LAZY_DIMENSION)
+      graph.edge_weight.materialize();
+  } else if (graph.edge_weight.size() != dimension) {
+    graph.adjacency.resize(dimension);
+    graph.edge_weight.resize(dimension, -1);
   }
   
+  // int16 weights when they fit
+  graph.edge_weight.compact();
+
   // setup default subgraph
   if (graph.subgraphs.size() == 0) {
     graph.subgraphs.push_back(vector<int>());
@@ -825,11 +1650,11 @@ int parse_input(string filename, TSP &graph) {
   graph.max_edge_cost = 0;
   for (int i=0; i < graph.size(); i++) {
     for (int j=0; j < graph.size(); j++) {
-      graph.edge_weight[i][j] = round(graph.edge_weight[i][j]);
-      if (graph.edge_weight[i][j] > graph.max_edge_cost)
-        graph.max_edge_cost = graph.edge_weight[i][j];
-      if (graph.edge_weight[i][j] < graph.min_edge_cost)
-        graph.min_edge_cost = graph.edge_weight[i][j];
+      graph.edge_weight.set(i, j, round(graph.edge_weight[i][j]));
+      if (graph.edge_weight(i,j) > graph.max_edge_cost)
+        graph.max_edge_cost = graph.edge_weight(i,j);
+      if (graph.edge_weight(i,j) < graph.min_edge_cost)
+        graph.min_edge_cost = graph.edge_weight(i,j);
     }
   }
   #endif
@@ -839,8 +1664,8 @@ int parse_input(string filename, TSP &graph) {
     cout << "Edge Weight:\n";
     for (int i=0; i < graph.size(); i++) {
       for (int j=0; j < graph.size(); j++) {
-        if (graph.adjacency[i][j])
-          printf("%7d", int(graph.edge_weight[i][j]));
+        if (graph.adjacency(i,j))
+          printf("%7d", int(graph.edge_weight(i,j)));
         else
           printf("%7d", 999999);
       }  
@@ -860,181 +1685,317 @@ int parse_input(string filename, TSP &graph) {
 
 
 
+#ifdef VER100
+/************************************************************//**
+ * @brief	condition implies exactly one of vars
+ * @version						v0.01b
+ ****************************************************************/
+static void add_one_in_a_set (Solver* solver, const Lit &condition, const vector<int> &vars) {
+    vec<Lit> clause;
+    if (condition != lit_Undef)
+        clause.push(~condition);
+    for (unsigned int i=0; i < vars.size(); i++)
+        clause.push(mkLit(vars[i]));
+    solver->addClause(clause);
+    for (unsigned int i=0; i < vars.size(); i++) {
+        for (unsigned int j=i+1; j < vars.size(); j++) {
+            clause.clear();
+            if (condition != lit_Undef)
+                clause.push(~condition);
+            clause.push(mkLit(vars[i], true));
+            clause.push(mkLit(vars[j], true));
+            solver->addClause(clause);
+        }
+    }
+}
+#endif
+
+
 /************************************************************//**
  * @brief	
  * @version						v0.01b
+ * Clauses are added to the solver directly. Subtours are eliminated
+ * by the encoding chosen with set_subtour_encoding(), each selected
+ * vertex is ordered after a single root (a level 0 var).
  ****************************************************************/
 int TSP::tsp2cnf (Solver* solver) {
 
-    // reduce tsp to sat
-    formula::Formula* tsp_formula = new formula::Formula(formula::F_AND);
-
     // setup structures
+    int n = adjacency.size();
     theory_vars.clear();
-    for (unsigned int vid00=0; vid00 < adjacency.size(); vid00++) {
-        vid_incoming_vars.push_back(vector<int>());
-        vid_outgoing_vars.push_back(vector<int>());
-    }
+    vid_incoming_vars.assign(n, vector<int>());
+    vid_outgoing_vars.assign(n, vector<int>());
 
     // constrain vertices to be in the graph if the edge is in the graph
+    // edge_lits[vid00*n + vid01] => edge from vid00 to vid01
     edge_var_offset               = -1;
-    Lit edge_lits[adjacency.size()][adjacency.size()];
-    for (unsigned int vid00=0; vid00 < adjacency.size(); vid00++) {
-        for (unsigned int vid01=0; vid01 < adjacency.size(); vid01++) {
+    vector<Lit> edge_lits(size_t(n)*n);
+    for (unsigned int vid00=0; vid00 < n; vid00++) {
+        for (unsigned int vid01=0; vid01 < n; vid01++) {
             Lit edge_lit                  = mkLit(solver->newVar());
             Lit source_lit                = mkLit(vid00);
             Lit target_lit                = mkLit(vid01);
-            edge_lits[vid00][vid01]       = edge_lit;
+            edge_lits[vid00*n + vid01]    = edge_lit;
             if (edge_var_offset < 0)
                 edge_var_offset = var(edge_lit);
             // edge implies source and target
-            tsp_formula->add(formula::constraint_implies(edge_lit, source_lit));
-            tsp_formula->add(formula::constraint_implies(edge_lit, target_lit));
+            solver->addClause(~edge_lit, source_lit);
+            solver->addClause(~edge_lit, target_lit);
         }
     }
 
+    vec<Lit> clause;
     #ifdef VER100
         // constrain vertices to have only one incoming and one outgoing edge
-        for (unsigned int vid00=0; vid00 < adjacency.size(); vid00++) {
+        for (unsigned int vid00=0; vid00 < n; vid00++) {
             vector<int> edge_vars;
-            formula::Formula *f0, *f1;
 
             // incoming edges
             edge_vars.clear();
-            for (unsigned int vid01=0; vid01 < adjacency.size(); vid01++)
-                if (adjacency[vid01][vid00])
-                    edge_vars.push_back(var(edge_lits[vid01][vid00]));
-            f0 = formula::constraint_one_in_a_set(edge_vars);
-            f1 = formula::constraint_implies(mkLit(vid2var(vid00)),f0);
-            tsp_formula->add(f1);
+            for (unsigned int vid01=0; vid01 < n; vid01++)
+                if (adjacency(vid01,vid00))
+                    edge_vars.push_back(var(edge_lits[vid01*n + vid00]));
+            add_one_in_a_set(solver, mkLit(vid2var(vid00)), edge_vars);
 
             // outgoing edges
             edge_vars.clear();
-            for (unsigned int vid01=0; vid01 < adjacency.size(); vid01++)
-                if (adjacency[vid00][vid01])
-                    edge_vars.push_back(var(edge_lits[vid00][vid01]));
-            f0 = formula::constraint_one_in_a_set(edge_vars);
-            f1 = formula::constraint_implies(mkLit(vid2var(vid00)),f0);
-            tsp_formula->add(f1);
+            for (unsigned int vid01=0; vid01 < n; vid01++)
+                if (adjacency(vid00,vid01))
+                    edge_vars.push_back(var(edge_lits[vid00*n + vid01]));
+            add_one_in_a_set(solver, mkLit(vid2var(vid00)), edge_vars);
         }
 
-        // constrain solution to only have one cycle (every vertex is reachable from every vertex)
-
-        // create reachable variables
-        // reachable[level][vid01] => vid01 is reachable on level
-        Lit reachable[adjacency.size()+1][adjacency.size()];
-        for (unsigned int level=0; level < adjacency.size()+1; level++)
-            for (unsigned int vid01=0; vid01 < adjacency.size(); vid01++)
-                reachable[level][vid01] = mkLit(solver->newVar());
-
         // level 0 of the soln has exactly one vertex true
         // vid00 is reachable on level 0 => vid00 is in the solution
+        vector<Lit> roots(n);
         vector<int> vids;
-        for (unsigned int vid00=0; vid00 < adjacency.size(); vid00++) {
-            vids.push_back(var(reachable[0][vid00]));
-            tsp_formula->add(formula::constraint_implies(reachable[0][vid00], mkLit(vid2var(vid00))));
+        for (unsigned int vid00=0; vid00 < n; vid00++) {
+            roots[vid00] = mkLit(solver->newVar());
+            vids.push_back(var(roots[vid00]));
+            solver->addClause(~roots[vid00], mkLit(vid2var(vid00)));
         }
-        tsp_formula->add(formula::constraint_one_in_a_set(vids));
+        add_one_in_a_set(solver, lit_Undef, vids);
     #else
         // constrain vertices to have only one incoming edge
-        for (unsigned int vid00=0; vid00 < adjacency.size(); vid00++) {
-            formula::Formula *f0 = new formula::Formula(formula::F_OR);
-            for (unsigned int vid01=0; vid01 < adjacency.size(); vid01++) {
-                if (adjacency[vid01][vid00]) {
-                    int edge_var = var(edge_lits[vid01][vid00]);
+        for (unsigned int vid00=0; vid00 < n; vid00++) {
+            clause.clear();
+            clause.push(~mkLit(vid2var(vid00)));
+            for (unsigned int vid01=0; vid01 < n; vid01++) {
+                if (adjacency(vid01,vid00)) {
+                    int edge_var = var(edge_lits[vid01*n + vid00]);
                     vid_incoming_vars[vid00].push_back(edge_var);
                     theory_vars.push_back(edge_var);
-                    Lit edge_lit = mkLit(edge_var, false);
-                    f0->add(edge_lit);
+                    clause.push(mkLit(edge_var, false));
                 }
             }
-            formula::Formula *f1 = formula::constraint_implies(mkLit(vid2var(vid00)),f0);
-            tsp_formula->add(f1);
+            solver->addClause(clause);
         }
 
         // constrain vertices to have only one outgoing edge
-        for (unsigned int vid00=0; vid00 < adjacency.size(); vid00++) {
-            formula::Formula *f0 = new formula::Formula(formula::F_OR);
-            for (unsigned int vid01=0; vid01 < adjacency.size(); vid01++) {
-                if (adjacency[vid00][vid01]) {
-                    int edge_var = var(edge_lits[vid00][vid01]);
+        for (unsigned int vid00=0; vid00 < n; vid00++) {
+            clause.clear();
+            clause.push(~mkLit(vid2var(vid00)));
+            for (unsigned int vid01=0; vid01 < n; vid01++) {
+                if (adjacency(vid00,vid01)) {
+                    int edge_var = var(edge_lits[vid00*n + vid01]);
                     vid_outgoing_vars[vid00].push_back(edge_var);
                     theory_vars.push_back(edge_var);
-                    Lit edge_lit = mkLit(edge_var, false);
-                    f0->add(edge_lit);
+                    clause.push(mkLit(edge_var, false));
                 }
             }
-            formula::Formula *f1 = formula::constraint_implies(mkLit(vid2var(vid00)),f0);
-            tsp_formula->add(f1);
+            solver->addClause(clause);
         }
 
-        /*
-         * constrain solution to only have one cycle (every vertex is reachable from every vertex)
-         */
-
-        // reachable[level][vid01] => vid01 is reachable on level
-        Lit reachable[adjacency.size()+1][adjacency.size()];
-        for (unsigned int level=0; level < adjacency.size()+1; level++)
-            for (unsigned int vid01=0; vid01 < adjacency.size(); vid01++)
-                reachable[level][vid01] = mkLit(solver->newVar());
-
         // vid00 is reachable on level 0 => vid00 is in the solution
+        vector<Lit> roots(n);
         level00_vars.clear();
-        for (unsigned int vid00=0; vid00 < adjacency.size(); vid00++) {
-            level00_vars.push_back(var(reachable[0][vid00]));
-            tsp_formula->add(formula::constraint_implies(reachable[0][vid00], mkLit(vid2var(vid00))));
+        for (unsigned int vid00=0; vid00 < n; vid00++) {
+            roots[vid00] = mkLit(solver->newVar());
+            level00_vars.push_back(var(roots[vid00]));
+            solver->addClause(~roots[vid00], mkLit(vid2var(vid00)));
         }
         // level 0 of the soln has exactly one vertex true
+        clause.clear();
         for (unsigned int i=0; i < level00_vars.size(); i++) {
             int vid_var = level00_vars[i];
             theory_vars.push_back(vid_var);
+            clause.push(mkLit(vid_var, false));
         }
-        tsp_formula->add(formula::constraint_at_least_one_in_a_set(level00_vars));
+        solver->addClause(clause);
     #endif
 
-    for (unsigned int level=1; level < adjacency.size()+1; level++) {
-        for (unsigned int vid01=0; vid01 < adjacency.size(); vid01++) {
-            formula::Formula *f0 = new formula::Formula(formula::F_OR);
-            for (unsigned int vid00=0; vid00 < adjacency.size(); vid00++) {
-                // vid01 is reachable
-                if (vid00 != vid01 && adjacency[vid00][vid01]) {
-                    formula::Formula *f1 = new formula::Formula(formula::F_AND);
-                    f1->add(reachable[level-1][vid00]);
-                    f1->add(edge_lits[vid00][vid01]);
-                    f0->add(f1);
+    /*
+     * constrain solution to only have one cycle (every vertex is reachable from every vertex)
+     */
+    if (subtour_encoding == MTZ_ENCODING)
+        ordering2cnf(solver, edge_lits, roots, false);
+    else if (subtour_encoding == BITVECTOR_ENCODING)
+        ordering2cnf(solver, edge_lits, roots, true);
+    else
+        reachability2cnf(solver, edge_lits, roots);
+
+    return 0;
+}
+
+
+/************************************************************//**
+ * @brief	Subtour elimination by reachability on n levels
+ * @version						v0.01b
+ * O(n^3) clauses and variables.
+ ****************************************************************/
+void TSP::reachability2cnf (Solver* solver, const vector<Lit> &edge_lits, const vector<Lit> &roots) {
+    int n = adjacency.size();
+
+    // reachable[level*n + vid01] => vid01 is reachable on level, level 0
+    // are the roots
+    vector<Lit> reachable(size_t(n+1)*n);
+    for (unsigned int level=0; level < n+1; level++)
+        for (unsigned int vid01=0; vid01 < n; vid01++)
+            reachable[level*n + vid01] = (level == 0) ? roots[vid01] : mkLit(solver->newVar());
+
+    // vid01 is reachable iff it is reachable from a reachable source,
+    // step implies the source is reachable and the edge is taken
+    vec<Lit> clause;
+    for (unsigned int level=1; level < n+1; level++) {
+        for (unsigned int vid01=0; vid01 < n; vid01++) {
+            Lit reachable_lit = reachable[level*n + vid01];
+            clause.clear();
+            clause.push(~reachable_lit);
+            for (unsigned int vid00=0; vid00 < n; vid00++) {
+                if (vid00 != vid01 && adjacency(vid00,vid01)) {
+                    Lit source_lit  = reachable[(level-1)*n + vid00];
+                    Lit edge_lit    = edge_lits[vid00*n + vid01];
+                    Lit step_lit    = mkLit(solver->newVar());
+                    solver->addClause(~step_lit, source_lit);
+                    solver->addClause(~step_lit, edge_lit);
+                    solver->addClause(reachable_lit, ~source_lit, ~edge_lit);
+                    clause.push(step_lit);
                 }
             }
-            // vid01 is reachable iff it is reachable from a reachable source
-            Lit f0_lit;
-            f0->export_cnf(f0_lit, NULL, solver);
-            tsp_formula->add(formula::constraint_iff(f0_lit, reachable[level][vid01]));
+            solver->addClause(clause);
         }
     }
 
     // if vertex is in the solution then it is reachable
     // FCI: change to iff and only if (remove reachable on a level line 433
-    for (unsigned int vid01=0; vid01 < adjacency.size(); vid01++) {
-        formula::Formula *f0 = new formula::Formula(formula::F_OR);
-        for (unsigned int level=1; level < adjacency.size()+1; level++) {
-            f0->add(reachable[level][vid01]);
+    for (unsigned int vid01=0; vid01 < n; vid01++) {
+        clause.clear();
+        clause.push(~mkLit(vid2var(vid01)));
+        for (unsigned int level=1; level < n+1; level++)
+            clause.push(reachable[level*n + vid01]);
+        solver->addClause(clause);
+    }
+}
+
+
+/************************************************************//**
+ * @brief	Subtour elimination by ordering the vertices
+ * @version						v0.01b
+ * Each vertex gets a ceil(log2 n) bit position, the root position 0.
+ * An edge into a vertex that is not the root then requires
+ *   successor:  pos(vid01) == pos(vid00) + 1, without overflow, or
+ *   otherwise:  pos(vid01) >  pos(vid00) (MTZ),
+ * so every cycle passes through the root. Successor shares the carry
+ * chain of each vertex and needs O(n log n) auxiliary variables, MTZ
+ * a comparator per edge, O(n^2 log n). Both need O(n^2 log n) clauses.
+ ****************************************************************/
+void TSP::ordering2cnf (Solver* solver, const vector<Lit> &edge_lits, const vector<Lit> &roots, bool successor) {
+    int n = adjacency.size();
+    int bits = 1;
+    while ((1 << bits) < n)
+        bits++;
+
+    // position[vid*bits + i] => bit i (lsb first) of the position of vid
+    vector<Lit> position(size_t(n)*bits);
+    for (unsigned int i=0; i < position.size(); i++)
+        position[i] = mkLit(solver->newVar());
+    for (unsigned int vid=0; vid < n; vid++)
+        for (unsigned int i=0; i < bits; i++)
+            solver->addClause(~roots[vid], ~position[vid*bits + i]);
+
+    // carry[vid*(bits+1) + i] => bits 0..i-1 of pos(vid) are set
+    vector<Lit> carry;
+    if (successor) {
+        carry.resize(size_t(n)*(bits+1));
+        for (unsigned int vid=0; vid < n; vid++) {
+            for (unsigned int i=0; i <= bits; i++) {
+                carry[vid*(bits+1) + i] = mkLit(solver->newVar());
+                if (i == 0) {
+                    solver->addClause(carry[vid*(bits+1)]);
+                    continue;
+                }
+                Lit in = carry[vid*(bits+1) + i-1], bit = position[vid*bits + i-1], out = carry[vid*(bits+1) + i];
+                solver->addClause(~out, in);
+                solver->addClause(~out, bit);
+                solver->addClause(out, ~in, ~bit);
+            }
         }
-        Lit f0_lit;
-        f0->export_cnf(f0_lit, NULL, solver);
-        tsp_formula->add(formula::constraint_implies(mkLit(vid2var(vid01)), f0_lit));
     }
 
-    Lit cnf_out;
-    if (int err = tsp_formula->export_cnf(cnf_out, NULL, solver) < 0) {
-        #ifdef DEBUG
-            cerr << "Error in Setup: export_cnf failed" << endl;
-        #endif
+    vec<Lit> clause;
+    for (unsigned int vid00=0; vid00 < n; vid00++) {
+        for (unsigned int vid01=0; vid01 < n; vid01++) {
+            if (!adjacency(vid00,vid01))
+                continue;
+            Lit edge_lit = edge_lits[vid00*n + vid01];
+            Lit root_lit = roots[vid01];
+            const Lit *from = &position[vid00*bits], *to = &position[vid01*bits];
+
+            if (successor) {
+                // to[i] == from[i] xor carry[i], and no carry out
+                const Lit *in = &carry[vid00*(bits+1)];
+                for (unsigned int i=0; i < bits; i++) {
+                    for (int k=0; k < 4; k++) {
+                        // to[i] is false when from[i] == in[i], true otherwise
+                        bool from_set = k & 1, in_set = k & 2;
+                        clause.clear();
+                        clause.push(~edge_lit);
+                        clause.push(root_lit);
+                        clause.push(from_set ? ~from[i] : from[i]);
+                        clause.push(in_set ? ~in[i] : in[i]);
+                        clause.push((from_set == in_set) ? ~to[i] : to[i]);
+                        solver->addClause(clause);
+                    }
+                }
+                solver->addClause(~edge_lit, root_lit, ~in[bits]);
+            } else {
+                // less[i] => from[0..i] < to[0..i], required for i = bits-1
+                Lit less = lit_Undef;
+                for (unsigned int i=0; i < bits; i++) {
+                    Lit below = less;
+                    less = mkLit(solver->newVar());
+                    solver->addClause(~less, ~from[i], to[i]);
+                    if (below == lit_Undef) {
+                        solver->addClause(~less, ~from[i]);
+                        solver->addClause(~less, to[i]);
+                    } else {
+                        solver->addClause(~less, ~from[i], below);
+                        solver->addClause(~less, to[i], below);
+                    }
+                }
+                solver->addClause(~edge_lit, root_lit, less);
+            }
+        }
     }
-    solver->addClause(cnf_out);
-    #ifdef DEBUG_SAT
-        cout << "tsp formula: " << endl << tsp_formula->str();
-    #endif  
+}
 
-    return 0;
+
+/************************************************************//**
+ * @brief	reachability (default), mtz or bitvector
+ * @version						v0.01b
+ ****************************************************************/
+bool TSP::set_subtour_encoding (string encoding) {
+  if (encoding == "reachability") {
+    subtour_encoding = REACHABILITY_ENCODING;
+  } else if (encoding == "mtz") {
+    subtour_encoding = MTZ_ENCODING;
+  } else if (encoding == "bitvector") {
+    subtour_encoding = BITVECTOR_ENCODING;
+  } else {
+    cerr << "Error: subtour encoding not supported\n";
+    return false;
+  }
+  return true;
 }
 
 
@@ -1093,7 +2054,7 @@ int TSP::lit_cost (const Lit &lit)
   if (eid >= 0 && sign(lit) == false) {
     int i,j;
     eid2edge(eid, i, j);
-    return edge_weight[i][j];
+    return edge_weight(i,j);
   } else return 0;
 }
 
@@ -1137,7 +2098,7 @@ int TSP::eid_cost (int eid)
 
   int from, to;
   eid2edge(eid, from, to);
-  return edge_weight[from][to];
+  return edge_weight(from,to);
 }
 
 
@@ -1151,21 +2112,68 @@ bool TSP::metric ()
     return true;
   } else if (_metric == 0) {
     return false;
+  } else if ((_metric = cached_property("metric")) >= 0) {
+    return _metric;
   } else {
-    for (int vid00=0; vid00<this->size(); vid00++) {
-      for (int vid01=0; vid01<this->size(); vid01++) {
-        for (int vid02=0; vid02<this->size(); vid02++) {
-          if (vid00 != vid01 && vid00 != vid02 && vid01 != vid02) {
-            if (edge_weight[vid00][vid01] + edge_weight[vid01][vid02] - edge_weight[vid00][vid02] < -1) {
-              _metric = 0;
-              return false;
-            }
-          }
-        }
-      }  
+    // for each vid00 and vid01, scan all vid02 at once over the two
+    // rows with the widest triangle kernel, around the two diagonal
+    // entries (which may hold INF)
+    static const Triangle_Kernel kernel = select_triangle_kernel();
+    int n = size();
+    atomic<bool> violated(false);
+
+    // int16 and small lazy matrices are widened once, larger lazy
+    // ones compute their rows as they go
+    vector<int32_t> table;
+    if (n <= LAZY_DIMENSION && (edge_weight.lazy() || edge_weight.width() == 16)) {
+      table.resize(size_t(n)*n);
+      for (int i=0; i<n; i++)
+        edge_weight.compute_row(i, &table[size_t(i)*n]);
     }
-    _metric = 1;
-    return true;
+    auto row = [&](int i, vector<int32_t> &buffer) {
+      return table.size() > 0 ? &table[size_t(i)*n] : edge_weight.row(i, &buffer[0]);
+    };
+    auto scan = [&](int vid00, vector<int32_t> &buffer00, vector<int32_t> &buffer01) {
+      const int32_t *row00 = row(vid00, buffer00);
+      for (int vid01=0; vid01<n && !violated; vid01++) {
+        if (vid01 == vid00)
+          continue;
+        const int32_t *row01 = row(vid01, buffer01);
+        int32_t w = row00[vid01];
+        int lo = min(vid00, vid01), hi = max(vid00, vid01);
+        bool hit = kernel(w, row00, row01, lo)
+                || kernel(w, row00+lo+1, row01+lo+1, hi-lo-1)
+                || kernel(w, row00+hi+1, row01+hi+1, n-hi-1);
+        #ifdef DEBUG
+          bool exact = false;
+          for (int vid02=0; vid02<n; vid02++)
+            if (vid02 != vid00 && vid02 != vid01 && w + row01[vid02] - row00[vid02] < -1)
+              exact = true;
+          assert (hit == exact);
+        #endif
+        if (hit)
+          violated = true;
+      }
+    };
+
+    // rows are independent, split them over the available cores
+    int threads = min<int>(thread::hardware_concurrency(), n / 64);
+    if (threads > 1) {
+      ThreadPool pool(threads);
+      pool.run(n, [&](int vid00) {
+        if (violated)
+          return;
+        vector<int32_t> buffer00(n), buffer01(n);
+        scan(vid00, buffer00, buffer01);
+      });
+    } else {
+      vector<int32_t> buffer00(n), buffer01(n);
+      for (int vid00=0; vid00<n && !violated; vid00++)
+        scan(vid00, buffer00, buffer01);
+    }
+    _metric = violated ? 0 : 1;
+    cache_property("metric", _metric);
+    return _metric;
   }
 }
 
@@ -1180,18 +2188,76 @@ bool TSP::symmetric ()
     return true;
   } else if (_symmetric == 0) {
     return false;
+  } else if ((_symmetric = cached_property("symmetric")) >= 0) {
+    return _symmetric;
   } else {
-    for (int vid00=0; vid00<this->size(); vid00++) {
+    _symmetric = 1;
+    for (int vid00=0; vid00<this->size() && _symmetric; vid00++) {
       for (int vid01=0; vid01<this->size(); vid01++) {
-        if ( abs(edge_weight[vid00][vid01] - edge_weight[vid01][vid00]) > 1 ) {
+        if ( abs(edge_weight(vid00,vid01) - edge_weight(vid01,vid00)) > 1 ) {
           _symmetric = 0;
-          return false;
+          break;
         }
       }  
     }
-    _symmetric = 1;
-    return true;
+    cache_property("symmetric", _symmetric);
+    return _symmetric;
+  }
+}
+
+
+/************************************************************//**
+ * @brief	Property detected on an earlier run, -1 if unknown
+ * @version						v0.01b
+ * The sidecar filename + ".props" holds the file hash followed by
+ * key=value pairs, and is ignored if the hash does not match.
+ ****************************************************************/
+int TSP::cached_property (const string &key)
+{
+  if (!property_cache || filename.empty())
+    return -1;
+  ifstream file((filename + ".props").c_str());
+  uint64_t hash;
+  string token;
+  if (!(file >> hex >> hash) || hash != file_hash)
+    return -1;
+  while (file >> token) {
+    size_t eq = token.find('=');
+    if (eq != string::npos && token.substr(0, eq) == key)
+      return atoi(token.c_str() + eq + 1);
+  }
+  return -1;
+}
+
+
+/************************************************************//**
+ * @brief	Record a detected property in the sidecar
+ * @version						v0.01b
+ * Written to a temporary file and renamed, so concurrent runs never
+ * read a partial sidecar. Failures (e.g. a read-only directory) are
+ * ignored.
+ ****************************************************************/
+void TSP::cache_property (const string &key, int value)
+{
+  if (!property_cache || filename.empty())
+    return;
+  const char *keys[] = {"metric", "symmetric"};
+  stringstream record;
+  record << hex << file_hash << dec;
+  for (int i=0; i<2; i++) {
+    int known = (key == keys[i]) ? value : cached_property(keys[i]);
+    if (known >= 0)
+      record << ' ' << keys[i] << '=' << known;
   }
+  record << '\n';
+
+  string sidecar = filename + ".props";
+  string temporary = sidecar + "." + to_string(getpid());
+  ofstream file(temporary.c_str());
+  file << record.str();
+  file.close();
+  if (file.fail() || rename(temporary.c_str(), sidecar.c_str()) != 0)
+    remove(temporary.c_str());
 }
 
 
@@ -1262,12 +2328,31 @@ string TSP::get_lkh_parameters ()
  * @version						v0.01b
  ****************************************************************/
 MST::MST (TSP* _graph)
-  : _size(0)
-  , _cost(0)
+  : _cost(0)
   , subset(_graph->size(), false)
-  , adjacency(_graph->size(), vector<bool>(_graph->size(), false))
 {
   graph = _graph;
+  reserve();
+}
+
+
+/************************************************************//**
+ * @brief	Size the scratch space so insert() never allocates
+ * @version						v0.01b
+ ****************************************************************/
+void MST::reserve ()
+{
+  int n = graph->size();
+  vids.reserve(n);
+  edges.reserve(n);
+  frames.reserve(n);
+  head.assign(n, -1);
+  next.assign(2*n, -1);
+  slot.assign(2*n, -1);
+  parent.assign(n, -1);
+  parent_slot.assign(n, -1);
+  stack.reserve(n);
+  best.resize(n);
 }
 
 
@@ -1275,244 +2360,286 @@ MST::MST (TSP* _graph)
  * @brief	
  * @version						v0.01b
  * Prim's Algorithm:  http://en.wikipedia.org/wiki/Prim%27s_algorithm
+ * The heap variant is used when few vertex pairs of the subset are
+ * adjacent, the O(k^2) key array variant otherwise.
  ****************************************************************/
 MST::MST (TSP* graph, const vector<int> subset)
-  : _size(0)
-  , _cost(0)
+  : _cost(0)
   , subset(graph->size(), false)
-  , adjacency(graph->size(), vector<bool>(graph->size(), false))
 {
   this->graph = graph;
-  vector<int> eids, Va, Vb(subset);
-  vector<bool> VaBool(graph->size(), false), VbBool(graph->size(), false);
-
-  for (int i=0; i<Vb.size(); i++)
-    VbBool[Vb[i]] = true;
-
-  int va = Vb.back();
-  Vb.pop_back();
-  Va.push_back(va);
-  VaBool[va] = true;
-  VbBool[va] = false;
-  for (int i=0; i<Vb.size(); i++) {
-    eids.push_back(graph->edge2eid(va, Vb[i]));
-//    eids.push_back(graph->edge2eid(Vb[i], va));
+  reserve();
+  if (subset.size() == 0)
+    return;
+
+  // count adjacent pairs within the subset
+  bool sparse = false;
+  if (!graph->adjacency.complete()) {
+    int words = (graph->size()+63)/64;
+    vector<uint64_t> mask(words, 0);
+    for (int i=0; i<subset.size(); i++)
+      mask[subset[i]/64] |= uint64_t(1) << (subset[i]%64);
+    long long pairs = 0;
+    for (int i=0; i<subset.size(); i++) {
+      const uint64_t *row = graph->adjacency.row(subset[i]);
+      for (int w=0; w<words; w++)
+        pairs += __builtin_popcountll(row[w] & mask[w]);
+    }
+    sparse = (8*pairs < (long long) subset.size()*subset.size());
   }
 
+  if (!sparse || !prim_sparse(subset))
+    prim_dense(subset);
+
   #ifdef DEBUG
-    printf("MST::MST_PRIMS()\n");
-    for (int j=0; j<subset.size(); j++)
-      printf("  |- subset[%d] = %d\n", j, subset[j]);
-    for (int j=0; j<Va.size(); j++)
-      printf("  |- Va[%d] = %d\n", j, Va[j]);
-    for (int j=0; j<Vb.size(); j++)
-      printf("  |- Vb[%d] = %d\n", j, Vb[j]);
-    for (int j=0; j<eids.size(); j++) {
-      int vid00, vid01;
-      graph->eid2edge(eids[j], vid00, vid01);      
-      printf("  |- eids[%d] = <%d,%d>, cost = %f\n", j, vid00, vid01, graph->edge_weight[vid00][vid01]);
-    }
+    printf("MST::MST_PRIMS(%s)\n", sparse ? "heap" : "dense");
+    for (int i=0; i<edges.size(); i++)
+      printf("  |- mst edge <%d,%d>.cost() = %d\n", edges[i].from, edges[i].to, edges[i].cost);
   #endif
+}
 
-  while (Vb.size() > 0) {
-    sort(eids.begin(), eids.end(), *graph);
-    for (int i=eids.size()-1; i>=0; i--) {
-      int eid = eids[i];
-      int from, to;
-      graph->eid2edge(eid, from, to);
-      #ifdef DEBUG
-        printf("  |- canidate edge <%d,%d>\n", from, to);
-      #endif
-      if (VaBool[from] && VbBool[to]) {
-        #ifdef DEBUG
-          printf("  |- minimum edge\n");
-          for (int j=0; j<Va.size(); j++)
-            printf("    |- Va[%d] = %d\n", j, Va[j]);
-          for (int j=0; j<Vb.size(); j++)
-            printf("    |- Vb[%d] = %d\n", j, Vb[j]);
-        #endif
-        int vb_index(-1);
-        for (int j=0; j<Vb.size(); j++) {
-          if (Vb[j] == to) {
-            vb_index = j;
-          } else {
-            // add edges now reachable from to
-            eids.push_back(graph->edge2eid(to, Vb[j]));
-//            eids.push_back(graph->edge2eid(Vb[j], to));
-            #ifdef DEBUG
-              printf("  |- prims new edge <%d,%d>.cost() = %d\n", to, Vb[j], int(graph->edge_weight[to][Vb[j]]));
-            #endif
-          }
-        }
-        #ifdef DEBUG
-          printf("  |- prims min edge <%d,%d>.cost() = %d\n", from, to, int(graph->edge_weight[from][to]));
-        #endif
 
-        Va.push_back(to);
-        Vb.erase(Vb.begin()+vb_index);
-        VaBool[to]          = true;
-        VbBool[to]          = false;
-        adjacency[from][to] = true;
-        adjacency[to][from] = true;
-        _cost += graph->edge_weight[from][to];
-        eids.erase(eids.begin()+i);
-        break;
+/************************************************************//**
+ * @brief	Prim with a key array, O(k^2) for k vertices
+ * @version						v0.01b
+ * key[i] is the cheapest edge from the tree to subset[i], the last
+ * vertex of the subset is the root like before.
+ ****************************************************************/
+void MST::prim_dense (const vector<int> &subset)
+{
+  int k = subset.size();
+  vector<int> key(k, INT32_MAX), from(k, -1), order(subset);
+  edges.clear();
+  vids.clear();
+  _cost = 0;
+
+  // order[0..size) are the vertices not yet in the tree
+  int size = k;
+  int root = order[k-1];
+  size--;
+  vids.push_back(root);
+  this->subset[root] = true;
+  int last = root;
+  while (size > 0) {
+    int best = 0;
+    for (int i=0; i<size; i++) {
+      int w = graph->edge_weight(last,order[i]);
+      if (w < key[i]) {
+        key[i]  = w;
+        from[i] = last;
       }
+      if (key[i] < key[best])
+        best = i;
     }
+    int to = order[best];
+    edges.push_back(Tree_Edge(from[best], to, key[best]));
+    _cost += key[best];
+    vids.push_back(to);
+    this->subset[to] = true;
+    last = to;
+
+    // swap the new tree vertex out of the open range
+    size--;
+    std::swap(order[best], order[size]);
+    std::swap(key[best], key[size]);
+    std::swap(from[best], from[size]);
   }
-
-  this->subset = VaBool;
-  _size  = Va.size();
 }
 
 
 /************************************************************//**
- * @brief	
+ * @brief	Prim with a binary heap over the adjacency bitsets
  * @version						v0.01b
- * Algorithm:
- *  http://www.sciencedirect.com/science/article/pii/0022000078900223
+ * Returns false, leaving the tree empty, if the adjacent pairs do
+ * not connect the subset.
  ****************************************************************/
-int MST::adjacent (int vid00, vector<int> &list)
+bool MST::prim_sparse (const vector<int> &subset)
 {
-  list.clear();
-  for (int vid01=0; vid01<graph->size(); vid01++) {
-    if (adjacency[vid00][vid01])
-      list.push_back(vid01);
+  int n     = graph->size();
+  int words = (n+63)/64;
+  vector<uint64_t> open(words, 0);
+  for (int i=0; i<subset.size(); i++)
+    open[subset[i]/64] |= uint64_t(1) << (subset[i]%64);
+
+  vector<int> key(n, INT32_MAX);
+  priority_queue< pair<int,int>, vector< pair<int,int> >, greater< pair<int,int> > > heap;
+  int root  = subset.back();
+  key[root] = 0;
+  heap.push(make_pair(0, root));
+  edges.clear();
+  vids.clear();
+  _cost = 0;
+  while (!heap.empty()) {
+    int vid00 = heap.top().second;
+    int cost  = heap.top().first;
+    heap.pop();
+    if (!(open[vid00/64] >> (vid00%64) & 1) || cost != key[vid00])
+      continue;
+    open[vid00/64] &= ~(uint64_t(1) << (vid00%64));
+    vids.push_back(vid00);
+    if (vid00 != root) {
+      edges.push_back(Tree_Edge(parent[vid00], vid00, cost));
+      _cost += cost;
+    }
+
+    // relax the adjacent vertices still outside the tree
+    const uint64_t *row = graph->adjacency.row(vid00);
+    for (int w=0; w<words; w++) {
+      uint64_t bits = row[w] & open[w];
+      while (bits) {
+        int vid01 = w*64 + __builtin_ctzll(bits);
+        bits &= bits-1;
+        int weight = graph->edge_weight(vid00,vid01);
+        if (weight < key[vid01]) {
+          key[vid01]    = weight;
+          parent[vid01] = vid00;
+          heap.push(make_pair(weight, vid01));
+        }
+      }
+    }
   }
-  return 0;
+
+  if (vids.size() != subset.size()) {
+    edges.clear();
+    vids.clear();
+    _cost = 0;
+    return false;
+  }
+  for (int i=0; i<vids.size(); i++)
+    this->subset[vids[i]] = true;
+  return true;
 }
 
 
 /************************************************************//**
  * @brief	
  * @version						v0.01b
- *
- * @param[in]
- *  z_vid             new vertex to add to tree
- *  r_vid             current vertex insertion into new tree
- *  t_eid             largest edge in path between w_vid and z_vid
- *  inserted          edges already inserted into new tree
- *  new_adjacency     edges in new tree
- *
- * @param[out]
- *  new_adjacency     edges in MST
- *  new_adjacency     edges in MST
- *
- * Algorithm:         http://www.sciencedirect.com/science/article/pii/0022000078900223
- *  w_vid             
- *  m_eid             largest edge between r_vid and z_vid
  ****************************************************************/
-void MST::_insert (int r_vid, int &t_eid)
+int MST::adjacent (int vid00, vector<int> &list)
 {
-  new_subset[r_vid] = true;
-  int m_eid         = graph->edge2eid(r_vid, z_vid);
-
-  vector<int> adjacent_list;
-  this->adjacent(r_vid, adjacent_list);
-  for (int i=0; i<adjacent_list.size(); i++) {
-    int w_vid = adjacent_list[i];
-    int w_eid = graph->edge2eid(w_vid, r_vid);
-
-    // adjacent vertices from old MST
-    if (!new_subset[w_vid] && graph->adjacency[w_vid][r_vid]) {
-
-      this->_insert(w_vid, t_eid);
-      int k_eid, h_eid;
-      
-      if (graph->edge_weight[w_vid][r_vid] > graph->eid_cost(t_eid)) {
-        k_eid = w_eid;
-        h_eid = t_eid;
-      } else {
-        k_eid = t_eid;
-        h_eid = w_eid;
-      }
-
-      int from, to;
-      graph->eid2edge(h_eid, from, to);
-      new_adjacency[from][to]     = true;
-      new_adjacency[to][from]     = true;
-
-      if (graph->eid_cost(k_eid) < graph->eid_cost(m_eid))
-        m_eid = k_eid;
-    }
+  list.clear();
+  for (int i=0; i<edges.size(); i++) {
+    if (edges[i].from == vid00)
+      list.push_back(edges[i].to);
+    else if (edges[i].to == vid00)
+      list.push_back(edges[i].from);
   }
-  t_eid = m_eid;
+  return 0;
 }
 
+
 /************************************************************//**
- * @brief	
+ * @brief	Add vid to the tree and return the new cost
  * @version						v0.01b
  * Algorithm:
  *  http://www.sciencedirect.com/science/article/pii/0022000078900223
+ *
+ * One post-order pass over the old tree rooted at vids[0]. best[r]
+ * is the cheapest edge that can connect the subtree of r to z_vid,
+ * starting with <r,z_vid>. For each tree edge <w,r> the cheaper of
+ * <w,r> and best[w] stays in the tree (in the slot of <w,r>) and the
+ * other one competes for best[r]. Finally best[root] joins z_vid.
  ****************************************************************/
-int MST::insert (int vid)
+int MST::insert (int z_vid)
 {
   #ifdef DEBUG
-    printf("MST::insert(%d)\n", vid);
-    printf("  |- MST.size() = %d\n", _size);
-    printf("  |- subset.size() = %d\n", subset.size());
-    for (int j=0; j<subset.size(); j++)
-      if (subset[j])
-        printf("  |- subset[%d] = true\n", j);
+    printf("MST::insert(%d)\n", z_vid);
+    printf("  |- MST.size() = %d\n", size());
+    printf("  |- subset = %s\n", str().c_str());
   #endif
-  if (_size == 0) {
-    subset[vid] = true;
-    _size++;
-    _cost = 0;
-  } else if (_size == 1) {
-    subset[vid] = true;
-    _size++;
-    for (int vid00=0; vid00<graph->size(); vid00++) {
-      for (int vid01=0; vid01<graph->size(); vid01++) {
-        if (vid00 != vid01 && subset[vid00] && subset[vid01]) {
-          adjacency[vid00][vid01] = true;
-          adjacency[vid01][vid00] = true;
-          _cost = graph->edge_weight[vid00][vid01];
-          break;
-        }
-      }    
+  Frame frame = {int(undo_log.size()), _cost};
+  frames.push_back(frame);
+  subset[z_vid] = true;
+  vids.push_back(z_vid);
+  int k = vids.size()-1;
+  if (k == 0)
+    return _cost;
+
+  // adjacency lists of the old tree
+  for (int i=0; i<k; i++)
+    head[vids[i]] = -1;
+  for (int i=0; i<edges.size(); i++) {
+    next[2*i]   = head[edges[i].from];
+    slot[2*i]   = i;
+    head[edges[i].from] = 2*i;
+    next[2*i+1] = head[edges[i].to];
+    slot[2*i+1] = i;
+    head[edges[i].to] = 2*i+1;
+  }
+
+  // depth first, head[r] doubles as the iterator over r's list
+  int root = vids[0];
+  parent[root]  = -1;
+  best[root]    = Tree_Edge(root, z_vid, graph->edge_weight(root,z_vid));
+  stack.clear();
+  stack.push_back(root);
+  while (!stack.empty()) {
+    int r_vid = stack.back();
+    if (head[r_vid] >= 0) {
+      int e     = head[r_vid];
+      head[r_vid] = next[e];
+      const Tree_Edge &edge = edges[slot[e]];
+      int w_vid = (edge.from == r_vid) ? edge.to : edge.from;
+      if (w_vid == parent[r_vid])
+        continue;
+      parent[w_vid]       = r_vid;
+      parent_slot[w_vid]  = slot[e];
+      best[w_vid]         = Tree_Edge(w_vid, z_vid, graph->edge_weight(w_vid,z_vid));
+      stack.push_back(w_vid);
+      continue;
     }
-  } else {
-    z_vid           = vid;
-    int t_eid       = -1;
-    new_subset      = vector<bool>(graph->size(), false);
-    new_subset[vid] = true;
-    new_adjacency   = vector< vector<bool> >(graph->size(), (vector<bool>(graph->size(), false)));
-    
-    int vid00(0);
-    for (; vid00<subset.size(); vid00++) {
-      if (subset[vid00] && vid00 != vid)
-        break;
+    stack.pop_back();
+    if (r_vid == root)
+      break;
+
+    int s                 = parent_slot[r_vid];
+    const Tree_Edge &t    = best[r_vid];
+    Tree_Edge tree_edge   = edges[s];
+    Tree_Edge k_edge, h_edge;
+    if (tree_edge.cost > t.cost) {
+      k_edge = tree_edge;
+      h_edge = t;
+    } else {
+      k_edge = t;
+      h_edge = tree_edge;
     }
-
-    this->_insert(vid00, t_eid);
-    subset              = new_subset;
-    adjacency           = new_adjacency;
-    subset[vid]         = true;
-    int from, to;
-    graph->eid2edge(t_eid, from, to);
-    adjacency[from][to] = true;
-    adjacency[to][from] = true;
-
-    _size = 0;
-    _cost = 0;
-    for (int vid00=0; vid00<graph->size(); vid00++) {
-      if (subset[vid00])
-        _size++;
-      for (int vid01=vid00+1; vid01<graph->size(); vid01++) {
-        if (adjacency[vid00][vid01]) {
-          _cost += graph->edge_weight[vid00][vid01];
-          #ifdef DEBUG
-            printf("  |- mst edge <%d,%d>.cost() = %f\n", vid00, vid01, graph->edge_weight[vid00][vid01]);
-          #endif
-        }
-
-      }
+    if (k_edge.from == tree_edge.from && k_edge.to == tree_edge.to) {
+      undo_log.push_back(make_pair(s, tree_edge));
+      edges[s] = h_edge;
+      _cost += h_edge.cost - tree_edge.cost;
     }
+    if (k_edge.cost < best[parent[r_vid]].cost)
+      best[parent[r_vid]] = k_edge;
   }
+  edges.push_back(best[root]);
+  _cost += best[root].cost;
 
+  #ifdef DEBUG
+    for (int i=0; i<edges.size(); i++)
+      printf("  |- mst edge <%d,%d>.cost() = %d\n", edges[i].from, edges[i].to, edges[i].cost);
+  #endif
   return _cost;
 }
 
 
+/************************************************************//**
+ * @brief	Undo the last insert()
+ * @version						v0.01b
+ ****************************************************************/
+void MST::undo ()
+{
+  assert(!frames.empty());
+  Frame frame = frames.back();
+  frames.pop_back();
+  while (undo_log.size() > frame.log_size) {
+    edges[undo_log.back().first] = undo_log.back().second;
+    undo_log.pop_back();
+  }
+  subset[vids.back()] = false;
+  vids.pop_back();
+  edges.resize(max(int(vids.size())-1, 0));
+  _cost = frame.cost;
+}
+
+
 